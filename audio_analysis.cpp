@@ -0,0 +1,465 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <bit>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "audio_analysis.hpp"
+
+
+#define NS_BEGIN(...) namespace __VA_ARGS__ {
+#define NS_END }
+NS_BEGIN()
+
+////////////////////////////////
+// 音声解析の補助関数．
+////////////////////////////////
+
+// little-endian reading.
+constexpr uint16_t read_u16(uint8_t const* p) { return p[0] | (p[1] << 8); }
+constexpr uint32_t read_u32(uint8_t const* p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// converts each interleaved sample to the average of its channels.
+template<size_t width>
+inline void average_channels(uint8_t const* src, size_t count, size_t channels, float* dst, auto&& sample)
+{
+	float const scale = 1.0f / channels;
+	for (size_t i = 0; i < count; i++) {
+		float sum = 0;
+		for (size_t c = 0; c < channels; c++, src += width) sum += sample(src);
+		dst[i] = sum * scale;
+	}
+}
+
+// the range of tempi to detect.
+constexpr double bpm_min = 60, bpm_max = 200,
+	bpm_preferred = 120, bpm_pref_octaves = 0.9;
+// the double tempo is taken instead when its autocorrelation is at least this ratio,
+// since the weighting alone prefers 87 BPM over 174 BPM for a plain click track.
+constexpr double double_tempo_ratio = 0.8;
+
+// the length of a FFT frame is chosen so it spans about this duration.
+constexpr double frame_seconds = 0.023;
+// the half width of the local mean subtracted from the envelope.
+constexpr double local_mean_seconds = 0.2;
+// the gain applied before the logarithmic compression of magnitudes.
+constexpr float log_compression = 100.0f;
+
+// the finest length of buckets that peak levels are aggregated from.
+constexpr size_t peak_base_len_max = 32;
+
+// the factor a transient must rise by from the previous bucket.
+constexpr int transient_rise = 2;
+
+constexpr int16_t to_pcm16(float v) {
+	return static_cast<int16_t>(std::clamp(v, -1.0f, 1.0f) * 32767);
+}
+NS_END
+
+
+////////////////////////////////
+// exported functions.
+////////////////////////////////
+namespace expt = enhanced_tl::audio_analysis;
+
+// WAV ファイルの解析．
+std::optional<expt::wav_layout> expt::parse_wav(std::span<uint8_t const> head, uint64_t file_size)
+{
+	if (head.size() < 12 ||
+		std::memcmp(head.data(), "RIFF", 4) != 0 ||
+		std::memcmp(head.data() + 8, "WAVE", 4) != 0) return std::nullopt;
+
+	std::optional<wav_format> format{};
+	for (size_t pos = 12; pos + 8 <= head.size(); ) {
+		auto const* const chunk = head.data() + pos;
+		uint64_t const size = read_u32(chunk + 4);
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0) {
+			if (size < 16 || pos + 8 + size > head.size()) return std::nullopt;
+
+			uint16_t tag = read_u16(chunk + 8);
+			// WAVE_FORMAT_EXTENSIBLE has the actual format at the head of the sub-format GUID.
+			if (tag == 0xfffe && size >= 40) tag = read_u16(chunk + 8 + 24);
+			wav_format const f{
+				.sample_rate = read_u32(chunk + 12),
+				.channels = read_u16(chunk + 10),
+				.bits_per_sample = read_u16(chunk + 22),
+				.block_align = read_u16(chunk + 20),
+				.is_float = tag == 3,
+			};
+			if (tag != 1 && tag != 3) return std::nullopt; // only PCM or IEEE float.
+			if (f.sample_rate == 0 || f.channels == 0) return std::nullopt;
+			if (f.is_float ?
+				f.bits_per_sample != 32 && f.bits_per_sample != 64 :
+				f.bits_per_sample != 8 && f.bits_per_sample != 16 && f.bits_per_sample != 24 && f.bits_per_sample != 32)
+				return std::nullopt;
+			if (f.block_align != f.channels * (f.bits_per_sample / 8)) return std::nullopt;
+			format = f;
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0) {
+			if (!format) return std::nullopt;
+
+			// some writers leave the size unfinished, so clamp it to the file.
+			uint64_t const offset = pos + 8;
+			uint64_t data_size = std::min(size, file_size - std::min(offset, file_size));
+			data_size -= data_size % format->block_align;
+			return wav_layout{ *format, offset, data_size };
+		}
+
+		// chunks are aligned to even positions.
+		pos += 8 + size + (size & 1);
+	}
+	return std::nullopt;
+}
+
+size_t expt::decode_mono(wav_format const& format, std::span<uint8_t const> bytes, std::span<float> out)
+{
+	size_t const count = std::min(bytes.size() / format.block_align, out.size());
+	auto const* const src = bytes.data();
+	auto* const dst = out.data();
+	size_t const ch = format.channels;
+
+	if (format.is_float) {
+		if (format.bits_per_sample == 32)
+			average_channels<4>(src, count, ch, dst, [](uint8_t const* p) {
+				float v; std::memcpy(&v, p, sizeof(v)); return v;
+			});
+		else average_channels<8>(src, count, ch, dst, [](uint8_t const* p) {
+			double v; std::memcpy(&v, p, sizeof(v)); return static_cast<float>(v);
+		});
+	}
+	else switch (format.bits_per_sample) {
+	case 8:
+		average_channels<1>(src, count, ch, dst, [](uint8_t const* p) {
+			return (p[0] - 128) * (1.0f / 128);
+		});
+		break;
+	case 16:
+		average_channels<2>(src, count, ch, dst, [](uint8_t const* p) {
+			return static_cast<int16_t>(read_u16(p)) * (1.0f / 32768);
+		});
+		break;
+	case 24:
+		average_channels<3>(src, count, ch, dst, [](uint8_t const* p) {
+			// sign-extend by placing the 24 bits at the top.
+			return static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24))
+				* (1.0f / 2147483648.0f);
+		});
+		break;
+	case 32:
+		average_channels<4>(src, count, ch, dst, [](uint8_t const* p) {
+			return static_cast<int32_t>(read_u32(p)) * (1.0f / 2147483648.0f);
+		});
+		break;
+	default: return 0;
+	}
+	return count;
+}
+
+// オンセット包絡の計算．
+expt::onset_envelope::onset_envelope(uint32_t sample_rate)
+	: frame_len{ std::bit_floor(std::max<size_t>(static_cast<size_t>(sample_rate * frame_seconds), 64)) }
+	, hop{ frame_len / 2 }, filled{ 0 }, sample_rate{ sample_rate }
+	, window(frame_len), cos_table(frame_len / 2), sin_table(frame_len / 2), bit_reversed(frame_len)
+	, buffer(frame_len), re(frame_len), im(frame_len), mag(frame_len / 2 + 1), prev_mag(frame_len / 2 + 1)
+{
+	constexpr double two_pi = 2 * std::numbers::pi;
+	for (size_t k = 0; k < frame_len; k++)
+		window[k] = static_cast<float>(0.5 - 0.5 * std::cos(two_pi * k / frame_len)); // Hann.
+	for (size_t k = 0; k < frame_len / 2; k++) {
+		cos_table[k] = static_cast<float>(std::cos(two_pi * k / frame_len));
+		sin_table[k] = static_cast<float>(-std::sin(two_pi * k / frame_len));
+	}
+	int const bits = std::countr_zero(frame_len);
+	for (size_t k = 0; k < frame_len; k++) {
+		uint32_t r = 0;
+		for (int b = 0; b < bits; b++) r |= static_cast<uint32_t>((k >> b) & 1) << (bits - 1 - b);
+		bit_reversed[k] = r;
+	}
+}
+
+void expt::onset_envelope::feed(std::span<float const> samples)
+{
+	while (!samples.empty()) {
+		size_t const n = std::min(samples.size(), frame_len - filled);
+		std::copy_n(samples.begin(), n, buffer.begin() + filled);
+		filled += n; samples = samples.subspan(n);
+
+		if (filled == frame_len) {
+			process_frame();
+
+			// keep the overlapping part for the next frame.
+			std::copy(buffer.begin() + hop, buffer.end(), buffer.begin());
+			filled -= hop;
+		}
+	}
+}
+
+void expt::onset_envelope::process_frame()
+{
+	size_t const N = frame_len, bins = N / 2 + 1;
+
+	// apply the window in the bit-reversed order.
+	for (size_t k = 0; k < N; k++) {
+		re[bit_reversed[k]] = buffer[k] * window[k];
+		im[k] = 0;
+	}
+
+	// radix-2 butterflies.
+	for (size_t len = 2; len <= N; len <<= 1) {
+		size_t const half = len / 2, step = N / len;
+		for (size_t i = 0; i < N; i += len) {
+			for (size_t j = 0; j < half; j++) {
+				float const wr = cos_table[j * step], wi = sin_table[j * step];
+				size_t const a = i + j, b = a + half;
+				float const
+					tr = wr * re[b] - wi * im[b],
+					ti = wr * im[b] + wi * re[b];
+				re[b] = re[a] - tr; im[b] = im[a] - ti;
+				re[a] += tr; im[a] += ti;
+			}
+		}
+	}
+
+	// log-compressed magnitudes of the non-negative frequencies.
+	// each step is a plain loop over contiguous arrays so the compiler can vectorize it.
+	for (size_t k = 0; k < bins; k++) mag[k] = std::sqrt(re[k] * re[k] + im[k] * im[k]);
+	for (size_t k = 0; k < bins; k++) mag[k] = std::log1p(log_compression * mag[k]);
+
+	// the spectral flux: sum of the increases from the previous frame.
+	float sum = 0;
+	for (size_t k = 0; k < bins; k++) sum += std::max(mag[k] - prev_mag[k], 0.0f);
+
+	// the first frame has nothing to compare with.
+	flux.push_back(flux.empty() ? 0 : sum);
+	std::swap(mag, prev_mag);
+}
+
+std::vector<float> expt::onset_envelope::finish()
+{
+	// subtract the local mean and rectify.
+	size_t const n = flux.size(),
+		w = std::max<size_t>(static_cast<size_t>(local_mean_seconds / hop_seconds()), 1);
+	std::vector<double> acc(n + 1, 0.0);
+	for (size_t i = 0; i < n; i++) acc[i + 1] = acc[i] + flux[i];
+
+	std::vector<float> ret(n);
+	for (size_t i = 0; i < n; i++) {
+		size_t const l = i < w ? 0 : i - w, r = std::min(i + w + 1, n);
+		auto const mean = (acc[r] - acc[l]) / (r - l);
+		ret[i] = static_cast<float>(std::max(flux[i] - mean, 0.0));
+	}
+	flux.clear();
+	return ret;
+}
+
+// テンポの推定．
+std::optional<expt::tempo_estimate> expt::estimate_tempo(std::span<float const> envelope, double hop_seconds, double time_offset)
+{
+	size_t const n = envelope.size();
+	auto const bpm_of = [&](double lag) { return 60 / (lag * hop_seconds); };
+	size_t const
+		lag_min = std::max<size_t>(static_cast<size_t>(60 / (bpm_max * hop_seconds)), 2),
+		lag_max = static_cast<size_t>(std::ceil(60 / (bpm_min * hop_seconds)));
+	if (n < 4 * lag_max) return std::nullopt; // too short.
+
+	// autocorrelation, weighted toward moderate tempi to settle octave ambiguities.
+	std::vector<double> acf(lag_max + 2, 0.0);
+	for (size_t lag = lag_min - 1; lag <= lag_max + 1; lag++) {
+		double sum = 0;
+		for (size_t i = 0; i + lag < n; i++) sum += envelope[i] * envelope[i + lag];
+		acf[lag] = sum / (n - lag);
+	}
+	// smooth over the neighbors, as the true period is rarely an integer.
+	auto const smoothed = [&](size_t lag) { return acf[lag] + 0.5 * (acf[lag - 1] + acf[lag + 1]); };
+	size_t best_lag = 0; double best_score = 0;
+	for (size_t lag = lag_min; lag <= lag_max; lag++) {
+		double const octaves = std::log2(bpm_of(lag) / bpm_preferred) / bpm_pref_octaves,
+			score = smoothed(lag) * std::exp(-0.5 * octaves * octaves);
+		if (score > best_score) best_lag = lag, best_score = score;
+	}
+	if (best_lag == 0) return std::nullopt; // no periodicity.
+
+	// every other beat of a fast tempo correlates as well as every beat,
+	// so the slower one wins by the weighting. take the faster if its beats are as strong;
+	// when the off-beats are weaker, as in most music, the half lag stays behind.
+	if (size_t const half = (best_lag + 1) / 2; half >= lag_min &&
+		smoothed(half) >= double_tempo_ratio * smoothed(best_lag)) {
+		// the peak near the half lag, which is not exactly half when the period isn't an integer.
+		best_lag = half;
+		if (half + 1 <= lag_max && acf[half + 1] > acf[best_lag]) best_lag = half + 1;
+		if (half - 1 >= lag_min && acf[half - 1] > acf[best_lag]) best_lag = half - 1;
+	}
+
+	// parabolic interpolation around the peak.
+	double period = static_cast<double>(best_lag);
+	if (double const l = acf[best_lag - 1], c = acf[best_lag], r = acf[best_lag + 1],
+		denom = l - 2 * c + r; denom < 0)
+		period += std::clamp(0.5 * (l - r) / denom, -0.5, 0.5);
+
+	// refine the period by folding the envelope at candidate periods,
+	// which also finds the phase of the beats.
+	size_t const bins = std::max<size_t>(16, 2 * static_cast<size_t>(std::ceil(period)));
+	std::vector<double> hist(bins);
+	auto const fold = [&](double p, size_t m) {
+		std::ranges::fill(hist, 0.0);
+		double ph = 0;
+		for (size_t i = 0; i < m; i++) {
+			hist[std::min(static_cast<size_t>(ph / p * bins), bins - 1)] += envelope[i];
+			if ((ph += 1) >= p) ph -= p;
+		}
+		// the peak of the slightly smoothed histogram.
+		size_t peak = 0; double peak_val = -1;
+		for (size_t b = 0; b < bins; b++) {
+			double const v = hist[b] + 0.5 * (hist[(b + bins - 1) % bins] + hist[(b + 1) % bins]);
+			if (v > peak_val) peak = b, peak_val = v;
+		}
+		return std::pair{ peak_val, peak };
+	};
+
+	// the candidates get finer each round, while the folded length grows
+	// so that a period off by half the spacing drifts by at most a frame.
+	constexpr int num_candidates = 16;
+	double width = 0.015 * period;
+	for (size_t m = 0; m < n; ) {
+		double const spacing = width / num_candidates;
+		m = std::min(n, static_cast<size_t>(period / spacing));
+
+		double best_p = period, best_val = -1;
+		for (int k = -num_candidates; k <= num_candidates; k++) {
+			double const p = period + k * spacing;
+			if (auto const [val, _] = fold(p, m); val > best_val) best_p = p, best_val = val;
+		}
+		period = best_p;
+		width = 2 * spacing;
+	}
+
+	// the phase as the centroid around the peak bin.
+	auto const [_, peak] = fold(period, n);
+	double const
+		l = hist[(peak + bins - 1) % bins], c = hist[peak], r = hist[(peak + 1) % bins],
+		offset = l + c + r > 0 ? (r - l) / (l + c + r) : 0,
+		phase = (peak + 0.5 + offset) / bins * period;
+
+	return tempo_estimate{
+		.bpm = bpm_of(period),
+		.first_beat = time_offset + phase * hop_seconds,
+	};
+}
+
+// ピーク列の作成．
+expt::peak_pyramid_builder::peak_pyramid_builder(std::span<double const> bucket_lengths, std::span<std::span<peak> const> outputs)
+	: base_filled{ 0 }, base_index{ 0 }, base{ INT16_MAX, INT16_MIN }
+{
+	// the base buckets must not be longer than any level's.
+	double const shortest = bucket_lengths.empty() ? 1.0 :
+		std::max(std::ranges::min(bucket_lengths), 1.0);
+	base_len = std::min(std::bit_floor(static_cast<size_t>(shortest)), peak_base_len_max);
+
+	for (size_t i = 0; i < bucket_lengths.size(); i++)
+		levels.push_back({ outputs[i], bucket_lengths[i], 0, { INT16_MAX, INT16_MIN } });
+}
+
+size_t expt::peak_pyramid_builder::level_size(double bucket_len, uint64_t num_samples)
+{
+	return static_cast<size_t>(std::ceil(num_samples / bucket_len)) + 1;
+}
+
+void expt::peak_pyramid_builder::feed(std::span<float const> samples)
+{
+	for (float const v : samples) {
+		auto const s = to_pcm16(v);
+		base.min = std::min(base.min, s);
+		base.max = std::max(base.max, s);
+		if (++base_filled == base_len) flush_base();
+	}
+}
+
+void expt::peak_pyramid_builder::flush_base()
+{
+	// each base bucket goes to the level bucket that contains its beginning.
+	double const begin = static_cast<double>(base_index * base_len);
+	for (auto& l : levels) {
+		size_t const index = static_cast<size_t>(begin / l.bucket_len);
+		if (index != l.index) {
+			if (l.index < l.out.size()) l.out[l.index] = l.curr;
+			l.index = index;
+			l.curr = base;
+		}
+		else {
+			l.curr.min = std::min(l.curr.min, base.min);
+			l.curr.max = std::max(l.curr.max, base.max);
+		}
+	}
+	base_index++; base_filled = 0;
+	base = { INT16_MAX, INT16_MIN };
+}
+
+void expt::peak_pyramid_builder::finish()
+{
+	if (base_filled > 0) flush_base();
+	for (auto& l : levels) {
+		if (l.index < l.out.size()) l.out[l.index] = l.curr;
+		l.index = l.out.size();
+	}
+}
+
+// 過渡点の検索．
+std::optional<size_t> expt::find_transient(std::span<peak const> level, size_t from, bool backward, int threshold,
+	std::span<coarse_level const> coarse)
+{
+	auto const is_transient = [&](size_t i) {
+		int const a = level[i].amplitude();
+		return a >= threshold && (i == 0 || a >= transient_rise * level[i - 1].amplitude());
+	};
+
+	// the quiet span of the coarse levels around the bucket `i`, as [first, last) of this level.
+	// a coarse bucket is a union of the same base buckets as the fine ones starting in it,
+	// so no fine bucket inside it is louder. one fine bucket at each end is left out
+	// for the rounding of the boundaries, which makes levels less than 4 times coarser useless.
+	auto const quiet_span = [&](size_t i) -> std::pair<size_t, size_t> {
+		for (auto const& [peaks, ratio] : coarse) {
+			if (ratio < 4) break;
+			size_t const j = static_cast<size_t>(i / ratio);
+			if (j >= peaks.size() || peaks[j].amplitude() >= threshold) continue;
+			size_t const
+				first = static_cast<size_t>(j * ratio) + 1,
+				last = static_cast<size_t>((j + 1) * ratio) - 1;
+			if (first <= i && i < last) return { first, last };
+		}
+		return { i, i };
+	};
+
+	if (backward) {
+		for (size_t i = std::min(from, level.size()); i-- > 0; ) {
+			if (auto const [first, last] = quiet_span(i); first < last) i = first;
+			else if (is_transient(i)) return i;
+		}
+	}
+	else {
+		for (size_t i = from; i < level.size(); i++) {
+			if (auto const [first, last] = quiet_span(i); first < last) i = last - 1;
+			else if (is_transient(i)) return i;
+		}
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,143 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+////////////////////////////////
+// 音声解析 (Windows に依存しない部分)．
+////////////////////////////////
+namespace enhanced_tl::audio_analysis
+{
+	/// @brief WAV ファイルのサンプル形式．
+	struct wav_format {
+		uint32_t sample_rate;
+		uint16_t channels;
+		uint16_t bits_per_sample;
+		uint16_t block_align;	// 1 サンプル (全チャンネル分) のバイト数．
+		bool is_float;
+	};
+
+	/// @brief WAV ファイル内のデータの配置．
+	struct wav_layout {
+		wav_format format;
+		uint64_t data_offset;	// "data" チャンクの中身のファイル先頭からの位置．
+		uint64_t data_size;		// "data" チャンクの中身のバイト数．
+	};
+
+	/// @brief RIFF ヘッダを解析する．
+	/// @param head ファイル先頭からの部分．"data" チャンクの中身の手前まで含まれている必要がある．
+	/// @param file_size ファイル全体のバイト数．
+	/// @return 解析結果．対応していない形式の場合は `std::nullopt`.
+	std::optional<wav_layout> parse_wav(std::span<uint8_t const> head, uint64_t file_size);
+
+	/// @brief インターリーブされたサンプルを，チャンネルを平均したモノラルの float 値に変換する．
+	/// @return 変換したサンプル数．`bytes` に収まる完全なサンプル数と `out` の長さのうち小さいほう．
+	size_t decode_mono(wav_format const& format, std::span<uint8_t const> bytes, std::span<float> out);
+
+	// モノラル音声を少しずつ与えて，オンセット包絡 (スペクトル流束) を計算するクラス．
+	class onset_envelope {
+		size_t frame_len, hop, filled;
+		uint32_t sample_rate;
+		// the precomputed tables for the FFT.
+		std::vector<float> window, cos_table, sin_table;
+		std::vector<uint32_t> bit_reversed;
+		// work buffers.
+		std::vector<float> buffer, re, im, mag, prev_mag;
+		std::vector<float> flux;
+
+		void process_frame();
+
+	public:
+		explicit onset_envelope(uint32_t sample_rate);
+
+		/// @brief サンプルを追加する．
+		void feed(std::span<float const> samples);
+
+		/// @brief 計算した包絡を取り出す．局所平均を差し引いて半波整流したもの．
+		std::vector<float> finish();
+
+		/// @brief 包絡の 1 要素あたりの秒数．
+		double hop_seconds() const { return static_cast<double>(hop) / sample_rate; }
+
+		/// @brief 包絡の 0 番目の要素に対応する時刻 (秒)．
+		double time_offset() const { return 0.5 * frame_len / sample_rate; }
+	};
+
+	/// @brief テンポ推定の結果．
+	struct tempo_estimate {
+		double bpm;			// 1 分あたりの拍数．
+		double first_beat;	// 最初の拍の時刻 (秒)．
+	};
+
+	/// @brief オンセット包絡からテンポと拍の位置を推定する．
+	/// @param envelope `onset_envelope::finish()` の戻り値．
+	/// @return 推定結果．音声が短すぎる場合などは `std::nullopt`.
+	std::optional<tempo_estimate> estimate_tempo(std::span<float const> envelope, double hop_seconds, double time_offset);
+
+	/// @brief 波形のピーク (最小値と最大値) 1 区間分．
+	struct peak {
+		int16_t min, max;
+		constexpr int amplitude() const { return std::max(-static_cast<int>(min), static_cast<int>(max)); }
+	};
+
+	// 区間の長さが異なる複数段のピーク列を，モノラル音声を少しずつ与えて作るクラス．
+	// 各段は共通の細かい区間から集計するので，1 サンプルあたりの処理は段数によらない．
+	class peak_pyramid_builder {
+		struct level_state {
+			std::span<peak> out;
+			double bucket_len;
+			size_t index;	// the bucket being accumulated.
+			peak curr;
+		};
+		std::vector<level_state> levels;
+		size_t base_len, base_filled;
+		uint64_t base_index;
+		peak base;
+
+		void flush_base();
+
+	public:
+		/// @param bucket_lengths 各段の 1 区間あたりのサンプル数．
+		/// @param outputs 各段の出力先．長さは `level_size()` 以上であること．
+		peak_pyramid_builder(std::span<double const> bucket_lengths, std::span<std::span<peak> const> outputs);
+
+		/// @brief 全体が `num_samples` サンプルの音声に対する，1 段分のピーク列の長さ．
+		static size_t level_size(double bucket_len, uint64_t num_samples);
+
+		/// @brief サンプルを追加する．
+		void feed(std::span<float const> samples);
+
+		/// @brief 途中の区間を書き出して終了する．
+		void finish();
+	};
+
+	/// @brief 過渡点の検索で，振幅が小さい範囲を読み飛ばすために使う粗い段．
+	struct coarse_level {
+		std::span<peak const> peaks;
+		double ratio;	// 1 区間が検索する段の何区間分か．
+	};
+
+	/// @brief ピーク列から，振幅が `threshold` 以上で，直前の区間の 2 倍以上に立ち上がる区間を探す．
+	/// @param from 検索の開始位置．右方向では `from` 以上，左方向では `from` 未満の区間が対象．
+	/// @param backward `true` で左方向に検索．
+	/// @param coarse 同じ音声から作った粗い段．振幅が `threshold` 未満の区間に含まれる範囲を読み飛ばす．粗いものから順に並べる．
+	/// @return 見つかった区間の位置．見つからなければ `std::nullopt`.
+	std::optional<size_t> find_transient(std::span<peak const> level, size_t from, bool backward, int threshold,
+		std::span<coarse_level const> coarse = {});
+}
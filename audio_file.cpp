@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <algorithm>
+#include <span>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "audio_analysis.hpp"
+#include "audio_file.hpp"
+
+
+#define NS_BEGIN(...) namespace __VA_ARGS__ {
+#define NS_END }
+NS_BEGIN()
+
+////////////////////////////////
+// 音声ファイルの読み込み．
+////////////////////////////////
+
+// the size of each mapped view, kept small for the 32-bit address space.
+constexpr size_t view_unit = 32 << 20;
+
+// the maximum size of the header to search for the "data" chunk.
+constexpr size_t header_max = 1 << 20;
+
+inline static uint64_t allocation_granularity()
+{
+	SYSTEM_INFO si; ::GetSystemInfo(&si);
+	return si.dwAllocationGranularity;
+}
+NS_END
+
+
+////////////////////////////////
+// exported functions.
+////////////////////////////////
+namespace expt = enhanced_tl::audio_file;
+
+expt::mapped_wav::mapped_wav(wchar_t const* path)
+{
+	file = ::CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER size;
+	if (::GetFileSizeEx(file, &size) == FALSE || size.QuadPart <= 0) return;
+	file_size = static_cast<uint64_t>(size.QuadPart);
+
+	mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) return;
+
+	// parse the header.
+	auto const head = view(0, static_cast<size_t>(std::min<uint64_t>(file_size, header_max)));
+	if (auto const l = audio_analysis::parse_wav(head, file_size)) {
+		layout = *l;
+		valid = true;
+	}
+}
+
+expt::mapped_wav::~mapped_wav()
+{
+	if (view_ptr != nullptr) ::UnmapViewOfFile(view_ptr);
+	if (mapping != nullptr) ::CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) ::CloseHandle(file);
+}
+
+std::span<uint8_t const> expt::mapped_wav::view(uint64_t offset, size_t len)
+{
+	if (mapping == nullptr || offset + len > file_size) return {};
+
+	// remap only when the range goes out of the current view.
+	if (view_ptr == nullptr || offset < view_offset || offset + len > view_offset + view_size) {
+		if (view_ptr != nullptr) ::UnmapViewOfFile(view_ptr);
+
+		static uint64_t const granularity = allocation_granularity();
+		view_offset = offset - offset % granularity;
+		view_size = static_cast<size_t>(std::min<uint64_t>(
+			std::max<uint64_t>(view_unit, offset + len - view_offset), file_size - view_offset));
+		view_ptr = static_cast<uint8_t const*>(::MapViewOfFile(mapping, FILE_MAP_READ,
+			static_cast<DWORD>(view_offset >> 32), static_cast<DWORD>(view_offset), view_size));
+		if (view_ptr == nullptr) return {};
+	}
+	return { view_ptr + (offset - view_offset), len };
+}
@@ -0,0 +1,91 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <concepts>
+#include <span>
+#include <vector>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "audio_analysis.hpp"
+
+
+////////////////////////////////
+// 音声ファイルの読み込み．
+////////////////////////////////
+namespace enhanced_tl::audio_file
+{
+	// WAV ファイルをメモリマップで一定の大きさずつ読み込むクラス．
+	// ファイル全体をメモリ上に置くことはない．
+	class mapped_wav {
+		HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+		uint64_t file_size = 0;
+		audio_analysis::wav_layout layout{};
+		bool valid = false;
+
+		// the currently mapped range of the file.
+		uint8_t const* view_ptr = nullptr;
+		uint64_t view_offset = 0;
+		size_t view_size = 0;
+
+	public:
+		/// @brief ファイルを開いてヘッダを解析する．失敗した場合は `operator bool()` が `false` になる．
+		explicit mapped_wav(wchar_t const* path);
+		~mapped_wav();
+		mapped_wav(mapped_wav const&) = delete;
+		mapped_wav& operator=(mapped_wav const&) = delete;
+
+		/// @brief 正しく開けたかどうか．
+		explicit operator bool() const { return valid; }
+
+		/// @brief サンプル形式．
+		audio_analysis::wav_format const& format() const { return layout.format; }
+
+		/// @brief ファイル全体のバイト数．
+		uint64_t size() const { return file_size; }
+
+		/// @brief 1 チャンネルあたりのサンプル数．
+		uint64_t num_samples() const { return layout.data_size / layout.format.block_align; }
+
+		/// @brief ファイルの指定範囲をマップして返す．`len` はマップの単位より十分小さいこと．
+		/// @return 次に呼び出すまで有効な範囲．失敗した場合は空．
+		std::span<uint8_t const> view(uint64_t offset, size_t len);
+
+		/// @brief 音声をモノラルに変換して，先頭から順に少しずつ `sink` に渡す．
+		/// @param sink `std::span<float const>` を受け取る関数．
+		/// @param chunk_samples 一度に渡す最大のサンプル数．
+		/// @return 最後まで読めた場合は `true`.
+		bool stream_mono(std::invocable<std::span<float const>> auto&& sink, size_t chunk_samples = 1 << 16)
+		{
+			if (!valid) return false;
+			size_t const align = layout.format.block_align;
+			std::vector<float> buf(chunk_samples);
+			for (uint64_t pos = 0; pos < layout.data_size; ) {
+				size_t const len = static_cast<size_t>(std::min<uint64_t>(layout.data_size - pos, chunk_samples * align));
+				auto const bytes = view(layout.data_offset + pos, len);
+				if (bytes.empty()) return false;
+
+				size_t const n = audio_analysis::decode_mono(layout.format, bytes, buf);
+				if (n == 0) return false;
+				sink(std::span<float const>{ buf.data(), n });
+				pos += n * align;
+			}
+			return true;
+		}
+	};
+}
@@ -0,0 +1,284 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <cmath>
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+using byte = uint8_t;
+#include <exedit.hpp>
+
+#include "enhanced_tl.hpp"
+#include "timeline.hpp"
+#include "audio_analysis.hpp"
+#include "audio_file.hpp"
+#include "audio_peaks.hpp"
+
+
+#define NS_BEGIN(...) namespace __VA_ARGS__ {
+#define NS_END }
+NS_BEGIN()
+
+////////////////////////////////
+// 波形のピークのキャッシュ．
+////////////////////////////////
+namespace aa = enhanced_tl::audio_analysis;
+namespace tlc = enhanced_tl::timeline::constants;
+
+// タイムラインのズーム値の分母．
+constexpr int zoom_denom = 10'000;
+
+// the length of the file head included in the hash.
+constexpr size_t key_head_len = 1 << 16;
+
+// キャッシュファイルの先頭に置く情報．ピーク列はこの後に段ごとに並ぶ．
+struct cache_header {
+	constexpr static uint32_t
+		magic_value = 'E' | ('T' << 8) | ('P' << 16) | ('K' << 24),
+		version_value = 1;
+
+	uint32_t magic, version;
+	uint64_t key;
+	uint64_t num_samples;
+	uint32_t sample_rate;
+	int32_t video_rate, video_scale;
+	uint32_t complete; // set after all the peaks are written.
+	struct level_info {
+		int32_t zoom_len;
+		uint32_t reserved;
+		double bucket_len; // samples per bucket, i.e. per pixel at this zoom.
+		uint64_t offset, count;
+	} levels[tlc::num_zoom_levels];
+};
+
+// FNV-1a hash.
+constexpr uint64_t fnv1a(uint64_t hash, void const* data, size_t len)
+{
+	for (auto const* p = static_cast<uint8_t const*>(data); len-- > 0; p++)
+		hash = (hash ^ *p) * 0x100000001b3;
+	return hash;
+}
+constexpr uint64_t fnv_basis = 0xcbf29ce484222325;
+
+// identifies the contents of a file by its size, last write time and the head.
+static uint64_t file_key(wchar_t const* path, enhanced_tl::audio_file::mapped_wav& wav)
+{
+	uint64_t hash = fnv_basis;
+	if (WIN32_FILE_ATTRIBUTE_DATA data;
+		::GetFileAttributesExW(path, GetFileExInfoStandard, &data) != FALSE) {
+		hash = fnv1a(hash, &data.nFileSizeHigh, sizeof(data.nFileSizeHigh));
+		hash = fnv1a(hash, &data.nFileSizeLow, sizeof(data.nFileSizeLow));
+		hash = fnv1a(hash, &data.ftLastWriteTime, sizeof(data.ftLastWriteTime));
+	}
+	auto const head = wav.view(0, static_cast<size_t>(std::min<uint64_t>(wav.size(), key_head_len)));
+	return fnv1a(hash, head.data(), head.size());
+}
+
+// the path of the cache file in the temporary folder.
+static std::wstring cache_path(uint64_t key)
+{
+	wchar_t dir[MAX_PATH + 1];
+	auto const len = ::GetTempPathW(static_cast<DWORD>(std::size(dir)), dir);
+	if (len == 0 || len >= std::size(dir)) return {};
+
+	std::wstring ret{ dir, len };
+	ret += L"enhanced_tl";
+	::CreateDirectoryW(ret.c_str(), nullptr); // may already exist.
+
+	wchar_t name[std::size(L"\\peaks_0123456789abcdef.bin")];
+	::swprintf_s(name, L"\\peaks_%016llx.bin", static_cast<unsigned long long>(key));
+	return ret + name;
+}
+
+// 読み込んだ音声のピーク列．
+#ifdef NDEBUG
+constinit
+#endif
+static struct {
+	HANDLE file = nullptr, mapping = nullptr;
+	uint8_t* view = nullptr;
+
+	int32_t start_frame = 0;
+	double samples_per_frame = 0;
+
+	cache_header* header() const { return reinterpret_cast<cache_header*>(view); }
+	std::span<aa::peak> level(int z) const {
+		auto const& l = header()->levels[z];
+		return { reinterpret_cast<aa::peak*>(view + l.offset), static_cast<size_t>(l.count) };
+	}
+
+	void close()
+	{
+		if (view != nullptr) ::UnmapViewOfFile(view);
+		if (mapping != nullptr) ::CloseHandle(mapping);
+		if (file != nullptr) ::CloseHandle(file);
+		view = nullptr; mapping = file = nullptr;
+	}
+} state;
+NS_END
+
+
+////////////////////////////////
+// exported functions.
+////////////////////////////////
+namespace expt = enhanced_tl::audio_peaks;
+
+bool expt::load(wchar_t const* path, int32_t start_frame, int video_rate, int video_scale)
+{
+	unload();
+	if (video_rate <= 0 || video_scale <= 0) return false;
+
+	enhanced_tl::audio_file::mapped_wav wav{ path };
+	if (!wav) return false;
+
+	// the layout of the cache, one level for each zoom of the timeline.
+	cache_header hdr{
+		.magic = cache_header::magic_value,
+		.version = cache_header::version_value,
+		.key = file_key(path, wav),
+		.num_samples = wav.num_samples(),
+		.sample_rate = wav.format().sample_rate,
+		.video_rate = video_rate, .video_scale = video_scale,
+		.complete = 1,
+	};
+	double const samples_per_frame = static_cast<double>(hdr.sample_rate) * video_scale / video_rate;
+	uint64_t size = sizeof(cache_header);
+	for (int z = 0; z < tlc::num_zoom_levels; z++) {
+		auto& l = hdr.levels[z];
+		l.zoom_len = std::max(exedit.timeline_zoom_lengths[z], 1);
+		l.bucket_len = std::max(samples_per_frame * zoom_denom / l.zoom_len, 1.0);
+		l.offset = size;
+		l.count = aa::peak_pyramid_builder::level_size(l.bucket_len, hdr.num_samples);
+		size += l.count * sizeof(aa::peak);
+	}
+
+	// open the cache file.
+	auto const cpath = cache_path(hdr.key);
+	if (cpath.empty()) return false;
+	state.file = ::CreateFileW(cpath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+		OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (state.file == INVALID_HANDLE_VALUE) {
+		state.file = nullptr;
+		return false;
+	}
+
+	// reuse the existing one if it was completed with the same layout.
+	bool reuse = false;
+	if (LARGE_INTEGER curr_size;
+		::GetFileSizeEx(state.file, &curr_size) != FALSE && static_cast<uint64_t>(curr_size.QuadPart) == size) {
+		cache_header old; DWORD read;
+		reuse = ::ReadFile(state.file, &old, sizeof(old), &read, nullptr) != FALSE &&
+			read == sizeof(old) && std::memcmp(&old, &hdr, sizeof(hdr)) == 0;
+	}
+	if (!reuse) {
+		// discard the stale contents; the mapping below extends the file with zeros.
+		LARGE_INTEGER const zero{};
+		::SetFilePointerEx(state.file, zero, nullptr, FILE_BEGIN);
+		::SetEndOfFile(state.file);
+	}
+
+	state.mapping = ::CreateFileMappingW(state.file, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+	if (state.mapping != nullptr)
+		state.view = static_cast<uint8_t*>(::MapViewOfFile(state.mapping, FILE_MAP_WRITE, 0, 0, 0));
+	if (state.view == nullptr) {
+		unload();
+		return false;
+	}
+
+	if (!reuse) {
+		// build all the levels in a single pass over the audio.
+		hdr.complete = 0;
+		*state.header() = hdr;
+
+		std::vector<double> lens{};
+		std::vector<std::span<aa::peak>> outputs{};
+		for (int z = 0; z < tlc::num_zoom_levels; z++) {
+			lens.push_back(hdr.levels[z].bucket_len);
+			outputs.push_back(state.level(z));
+		}
+		aa::peak_pyramid_builder builder{ lens, outputs };
+		if (!wav.stream_mono([&](std::span<float const> samples) { builder.feed(samples); })) {
+			unload();
+			return false;
+		}
+		builder.finish();
+
+		// mark as complete only after the peaks reach the file.
+		::FlushViewOfFile(state.view, 0);
+		state.header()->complete = 1;
+	}
+
+	state.start_frame = start_frame;
+	state.samples_per_frame = samples_per_frame;
+	return true;
+}
+
+void expt::unload()
+{
+	state.close();
+}
+
+bool expt::is_loaded()
+{
+	return state.view != nullptr;
+}
+
+std::optional<int32_t> expt::find_transient(int32_t frame, bool to_left, int threshold)
+{
+	if (!is_loaded()) return std::nullopt;
+
+	// use the level of the current zoom, so the steps match what the timeline can show.
+	int const z = std::clamp(*exedit.curr_timeline_zoom_level, 0, tlc::num_zoom_levels - 1);
+	auto const level = state.level(z);
+	double const bucket_len = state.header()->levels[z].bucket_len,
+		spf = state.samples_per_frame;
+	int const thresh = std::clamp(threshold, 0, 1000) * INT16_MAX / 1000;
+
+	// the coarser levels, coarsest first, let the search skip quiet spans at once.
+	std::vector<aa::coarse_level> coarse{};
+	for (int c = 0; c < z; c++)
+		coarse.push_back({ state.level(c), state.header()->levels[c].bucket_len / bucket_len });
+
+	auto const frame_of = [&](size_t bucket) {
+		return state.start_frame + static_cast<int32_t>(bucket * bucket_len / spf);
+	};
+
+	// the bucket containing the frame.
+	double const b = std::floor((frame - state.start_frame) * spf / bucket_len);
+	if (to_left) {
+		if (b <= 0) return std::nullopt;
+		size_t from = static_cast<size_t>(std::min<double>(b, static_cast<double>(level.size())));
+		while (auto const i = aa::find_transient(level, from, true, thresh, coarse)) {
+			if (int32_t const f = frame_of(*i); f < frame) return f;
+			from = *i;
+		}
+	}
+	else {
+		size_t from = b < 0 ? 0 : static_cast<size_t>(b) + 1;
+		while (auto const i = aa::find_transient(level, from, false, thresh, coarse)) {
+			if (int32_t const f = frame_of(*i); f > frame) return f;
+			from = *i + 1;
+		}
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,49 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+
+////////////////////////////////
+// 波形のピークを利用した移動．
+////////////////////////////////
+namespace enhanced_tl::audio_peaks
+{
+	/// @brief 波形ステップ用の音声を読み込む．
+	/// ズーム段階ごとのピーク列をキャッシュファイルから読むか，なければ作成する．
+	/// @param path WAV ファイルのパス．
+	/// @param start_frame 音声の先頭に対応するフレーム位置．
+	/// @param video_rate フレームレートの分子．
+	/// @param video_scale フレームレートの分母．
+	/// @return 成功した場合は `true`.
+	bool load(wchar_t const* path, int32_t start_frame, int video_rate, int video_scale);
+
+	/// @brief 読み込んだ音声を破棄する．
+	void unload();
+
+	/// @brief 音声が読み込まれているかどうか．
+	bool is_loaded();
+
+	/// @brief 現在のズーム段階のピーク列から，音の立ち上がりの位置を探す．
+	/// @param frame 検索を始めるフレーム位置．この位置自身は対象外．
+	/// @param to_left `true` で左方向に検索．
+	/// @param threshold 振幅のしきい値，フルスケールに対する千分率．
+	/// @return 見つかったフレーム位置．見つからない場合や音声を読み込んでいない場合は `std::nullopt`.
+	std::optional<int32_t> find_transient(int32_t frame, bool to_left, int threshold);
+}
@@ -0,0 +1,125 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <concepts>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+
+////////////////////////////////
+// 拍数線の位置の整数計算．
+////////////////////////////////
+// `BPM_Grid` のうち拡張編集に依存しない部分．1 拍は `n / d` フレームで表す．
+namespace enhanced_tl::BPM_Grid::beat_lines
+{
+	// division that rounds away from zero.
+	// `divisor` is assumed to be positive.
+	template<std::integral IntT>
+	constexpr IntT away_from_zero_div(IntT dividend, std::integral auto divisor) {
+		if constexpr (std::signed_integral<IntT>)
+			dividend = dividend > 0 ?
+				dividend + static_cast<IntT>(divisor - 1) :
+				dividend - static_cast<IntT>(divisor - 1);
+		else dividend += static_cast<IntT>(divisor - 1);
+		return dividend / static_cast<IntT>(divisor);
+	}
+
+	// division that rounds toward negative infinity, together with the non-negative remainder.
+	// `divisor` is assumed to be positive.
+	constexpr std::pair<int64_t, int64_t> floor_divmod(int64_t dividend, int64_t divisor)
+	{
+		auto quot = dividend / divisor, rem = dividend % divisor;
+		if (rem < 0) { quot--; rem += divisor; }
+		return { quot, rem };
+	}
+
+	/// @brief フレーム位置 `pos` 上かそれより左にある拍数線のうち，最も大きい拍数．
+	constexpr int64_t beat_from_pos(int32_t pos, int64_t n, int64_t d, int32_t origin)
+	{
+		// frame -> beat is by rounding toward zero.
+		int64_t const p = static_cast<int64_t>(pos) - origin;
+		// handle negative positions differently.
+		auto beats = (p < 0 ? -1 - p : p) * d / n;
+		return p < 0 ? -1 - beats : beats;
+	}
+
+	/// @brief 拍数 `beat` の拍数線のフレーム位置．
+	constexpr int32_t pos_from_beat(int64_t beat, int64_t n, int64_t d, int32_t origin)
+	{
+		// beat -> frame is by rounding away from zero.
+		return static_cast<int32_t>(away_from_zero_div(beat * n, d)) + origin;
+	}
+
+	/// @brief 拍数線 1 本分の情報．
+	struct line { int64_t beat; int32_t pos; };
+
+	/// @brief 拍数線を左から順に列挙するイテレータ．
+	/// 除算は最初の 1 本だけで，以降は剰余の繰り上がりで次の位置を求める．
+	struct line_iterator {
+		using value_type = line;
+		using difference_type = std::ptrdiff_t;
+
+		line operator*() const { return { beat, pos }; }
+		line_iterator& operator++() { step(); return *this; }
+		line_iterator operator++(int) { auto ret = *this; step(); return ret; }
+		bool operator==(std::default_sentinel_t) const { return pos > pos_R; }
+
+		/// @brief フレーム範囲 `[pos_L, pos_R]` にある拍数線の最初の 1 本を指すイテレータ．
+		/// `n` と `d` は正であること．
+		static constexpr line_iterator first_in(int64_t n, int64_t d, int32_t origin, int32_t pos_L, int32_t pos_R)
+		{
+			line_iterator it{};
+			it.step_d = d;
+			std::tie(it.step_quot, it.step_rem) = floor_divmod(n, d);
+			it.pos_R = pos_R; it.origin = origin;
+
+			// the first line is the one next to the last line left of `pos_L`,
+			// the same rounding as `beat_from_pos()`.
+			int64_t const p = static_cast<int64_t>(pos_L) - 1 - origin;
+			it.beat = (p < 0 ? -1 - (-1 - p) * d / n : p * d / n) + 1;
+			std::tie(it.quot, it.rem) = floor_divmod(it.beat * n, d);
+			it.pos = it.calc_pos();
+			while (it.pos < pos_L) it.step();
+			return it;
+		}
+		/// @brief 何も列挙しないイテレータ．
+		static constexpr line_iterator none()
+		{
+			line_iterator it{};
+			it.pos_R = std::numeric_limits<int32_t>::min();
+			return it;
+		}
+
+	private:
+		// `beat * n == quot * d + rem` where `0 <= rem < d`.
+		int64_t beat = 0, quot = 0, rem = 0;
+		// `n == step_quot * d + step_rem`.
+		int64_t step_quot = 0, step_rem = 0, step_d = 1;
+		int32_t pos = 0, pos_R = 0, origin = 0;
+
+		// beat -> frame is by rounding away from zero.
+		constexpr int32_t calc_pos() const {
+			return static_cast<int32_t>(quot + (beat > 0 && rem > 0 ? 1 : 0)) + origin;
+		}
+		constexpr void step()
+		{
+			beat++; quot += step_quot; rem += step_rem;
+			if (rem >= step_d) { rem -= step_d; quot++; }
+			pos = calc_pos();
+		}
+	};
+}
@@ -13,6 +13,13 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 #include <cstdint>
 #include <algorithm>
 #include <concepts>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include <string_view>
+#include <cstring>
+#include <charconv>
+#include <cmath>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -33,19 +40,123 @@ NS_BEGIN()
 // BPM グリッドの丸め計算．
 ////////////////////////////////
 
-// division that rounds away from zero.
-// `divisor` is assumed to be positive.
-template<std::integral IntT>
-constexpr IntT away_from_zero_div(IntT dividend, std::integral auto divisor) {
-	if constexpr (std::signed_integral<IntT>)
-		dividend = dividend > 0 ?
-			dividend + static_cast<IntT>(divisor - 1) :
-			dividend - static_cast<IntT>(divisor - 1);
-	else dividend += static_cast<IntT>(divisor - 1);
-	return dividend / static_cast<IntT>(divisor);
+constexpr int one_bpm = 600'000;
+
+// the frame rate is calculated as: fi.video_rate / fi.video_scale.
+static AviUtl::FileInfo file_info()
+{
+	AviUtl::FileInfo fi{};
+	if (*exedit.editp != nullptr) exedit.fp->exfunc->get_file_info(*exedit.editp, &fi);
+	return fi;
 }
 
-constexpr int one_bpm = 600'000;
+// テンポマップの 1 区間．
+struct tempo_segment {
+	int32_t start; // the first frame of the segment, 0-based.
+	int32_t tempo; // BPM multiplied by 10'000, the same unit as `timeline_BPM_tempo`.
+	int32_t meter; // beats per measure, or 0 to follow the setting of exedit.
+};
+
+// テンポマップをプロジェクトファイルと同じ場所にある "(プロジェクト名).tempo.ini" から読み込む．
+// [tempo] セクションに "開始フレーム=BPM" または "開始フレーム=BPM,拍子" の形式で列挙する．
+// 開始フレームは拡張編集の表示と同じく 1 から数える．
+static std::vector<tempo_segment> load_tempo_map()
+{
+	std::vector<tempo_segment> ret{};
+
+	// find the file path.
+	char path[MAX_PATH];
+	if (!project_sidecar_path(path, ".tempo.ini")) return ret;
+
+	// read the whole section, enlarging the buffer as needed.
+	std::vector<char> buf(1 << 12);
+	while (::GetPrivateProfileSectionA("tempo", buf.data(), static_cast<DWORD>(buf.size()), path) + 2 >= buf.size())
+		buf.resize(2 * buf.size());
+
+	// parse each "key=value" line.
+	for (char const* line = buf.data(); *line != '\0'; line += std::strlen(line) + 1) {
+		std::string_view const str = line;
+		auto const eq = str.find('=');
+		if (eq == str.npos) continue;
+
+		int32_t frame = 0, meter = 0; double bpm = 0;
+		auto const key = str.substr(0, eq), val = str.substr(eq + 1);
+		auto const comma = std::min(val.find(','), val.size());
+		if (std::from_chars(key.data(), key.data() + key.size(), frame).ec != std::errc{} ||
+			std::from_chars(val.data(), val.data() + comma, bpm).ec != std::errc{} ||
+			(comma < val.size() &&
+				std::from_chars(val.data() + comma + 1, val.data() + val.size(), meter).ec != std::errc{}))
+			continue;
+		if (frame < 1 || !(bpm > 0 && bpm * 10'000 < std::numeric_limits<int32_t>::max()) || meter < 0)
+			continue;
+
+		ret.push_back({ frame - 1, static_cast<int32_t>(std::lround(bpm * 10'000)), meter });
+	}
+
+	// sort by the starting frame, the later ones winning on duplicates.
+	std::ranges::stable_sort(ret, {}, &tempo_segment::start);
+	auto const dup = std::ranges::unique(ret.rbegin(), ret.rend(), {}, &tempo_segment::start);
+	ret.erase(ret.begin(), dup.begin().base());
+	return ret;
+}
+
+// 拡張編集の設定値とテンポマップから作った `TempoGrid` のキャッシュ．
+#ifdef NDEBUG
+constinit
+#endif
+static struct {
+	// the frame rate and the tempo map, re-loaded only when the edit handle changes.
+	bool file_valid = false;
+	AviUtl::EditHandle* editp = nullptr;
+	int32_t video_rate = 0, video_scale = 0;
+	std::vector<tempo_segment> tempo_map{};
+
+	// the values the grid was made from.
+	bool grid_valid = false;
+	int32_t tempo = 0, origin = 0, num_beats = 0, beats_numer = 0, beats_denom = 0;
+	enhanced_tl::BPM_Grid::TempoGrid grid{};
+
+	void update_file_info()
+	{
+		if (file_valid && editp == *exedit.editp) return;
+		auto const fi = file_info();
+		file_valid = true;
+		editp = *exedit.editp;
+		video_rate = fi.video_rate; video_scale = fi.video_scale;
+		tempo_map = load_tempo_map();
+		grid_valid = false;
+	}
+
+	void build_grid()
+	{
+		using enhanced_tl::BPM_Grid::BPM_Grid;
+		auto const numer_of = [&](int meter) {
+			return beats_numer < 0 ? -beats_numer * meter : beats_numer;
+		};
+
+		grid.pieces.clear();
+		if (tempo_map.empty()) {
+			// the single global tempo of exedit.
+			BPM_Grid const g{ origin, numer_of(num_beats), beats_denom, video_rate, video_scale, tempo };
+			if (g) grid.pieces.push_back({ g, 0 });
+			return;
+		}
+
+		for (auto const& seg : tempo_map) {
+			BPM_Grid const g{ seg.start, numer_of(seg.meter > 0 ? seg.meter : num_beats),
+				beats_denom, video_rate, video_scale, seg.tempo };
+			if (!g) { grid.pieces.clear(); return; }
+
+			// count the lines of the previous piece that lie left of this segment.
+			int64_t first_beat = 0;
+			if (!grid.pieces.empty()) {
+				auto const& [prev, prev_first] = grid.pieces.back();
+				first_beat = prev_first + prev.beat_from_pos(seg.start - 1) + 1;
+			}
+			grid.pieces.push_back({ g, first_beat });
+		}
+	}
+} cache;
 NS_END
 
 ////////////////////////////////
@@ -57,43 +168,123 @@ expt::BPM_Grid::BPM_Grid(int beats_numer, int beats_denom)
 	: BPM_Grid(*exedit.timeline_BPM_frame_origin - 1, beats_numer, beats_denom) {}
 
 expt::BPM_Grid::BPM_Grid(int origin, int beats_numer, int beats_denom)
-	: origin{ origin }
-{
-	// find the frame rate.
-	AviUtl::FileInfo fi; // the frame rate is calculated as: fi.video_rate / fi.video_scale.
-	if (*exedit.editp == nullptr) fi = {};
-	else exedit.fp->exfunc->get_file_info(*exedit.editp, &fi);
+	: BPM_Grid{ origin, beats_numer, beats_denom, file_info() } {}
 
-	// find the tempo in BPM.
-	auto tempo = *exedit.timeline_BPM_tempo;
+expt::BPM_Grid::BPM_Grid(int origin, int beats_numer, int beats_denom, AviUtl::FileInfo const& fi)
+	: BPM_Grid{ origin, beats_numer, beats_denom, fi.video_rate, fi.video_scale, *exedit.timeline_BPM_tempo } {}
 
+expt::BPM_Grid::BPM_Grid(int origin, int beats_numer, int beats_denom, int video_rate, int video_scale, int tempo)
+	: origin{ origin }
+{
 	// calculate "frames per beat".
-	if (fi.video_rate > 0 && fi.video_scale > 0 && tempo > 0) {
-		fpb_n = static_cast<int64_t>(fi.video_rate) * (one_bpm * beats_numer);
-		fpb_d = static_cast<int64_t>(fi.video_scale) * (tempo * beats_denom);
+	if (video_rate > 0 && video_scale > 0 && tempo > 0) {
+		fpb_n = static_cast<int64_t>(video_rate) * (one_bpm * beats_numer);
+		fpb_d = static_cast<int64_t>(video_scale) * (tempo * beats_denom);
 	}
 	else fpb_n = fpb_d = 0;
 }
 
+expt::TempoGrid const& expt::current_grid(int beats_numer, int beats_denom)
+{
+	cache.update_file_info();
+
+	// compare the raw values to the ones the grid was made from.
+	int32_t const
+		tempo = *exedit.timeline_BPM_tempo,
+		origin = *exedit.timeline_BPM_frame_origin - 1,
+		num_beats = *exedit.timeline_BPM_num_beats;
+	if (!cache.grid_valid || cache.tempo != tempo || cache.origin != origin || cache.num_beats != num_beats ||
+		cache.beats_numer != beats_numer || cache.beats_denom != beats_denom) {
+		cache.tempo = tempo; cache.origin = origin; cache.num_beats = num_beats;
+		cache.beats_numer = beats_numer; cache.beats_denom = beats_denom;
+		cache.build_grid();
+		cache.grid_valid = true;
+	}
+	return cache.grid;
+}
+
+bool expt::has_tempo_map()
+{
+	cache.update_file_info();
+	return !cache.tempo_map.empty();
+}
+
+void expt::invalidate_file_info()
+{
+	cache.file_valid = false;
+}
+
 // フレーム位置から拍数を計算．
 // フレーム位置 pos 上かそれより左にある拍数線のうち，最も大きい拍数を返す．
 // (1 フレームに複数の拍数線が重なっている状態でも，そのうち最も大きい拍数が対象．)
 int64_t expt::BPM_Grid::beat_from_pos(int32_t pos) const
 {
-	// frame -> beat is by rounding toward zero.
-	pos -= origin;
-	// handle negative positions differently.
-	auto beats = (pos < 0 ? -1 - pos : pos) * fpb_d / fpb_n;
-	return pos < 0 ? -1 - beats : beats;
+	return beat_lines::beat_from_pos(pos, fpb_n, fpb_d, origin);
 }
 
 // 拍数からフレーム位置を計算．
 // 拍数 beat で描画される拍数線のフレーム位置を返す．
 int32_t expt::BPM_Grid::pos_from_beat(int64_t beat) const
 {
-	// beat -> frame is by rounding away from zero.
-	return static_cast<int32_t>(away_from_zero_div(beat * fpb_n, fpb_d)) + origin;
+	return beat_lines::pos_from_beat(beat, fpb_n, fpb_d, origin);
 	auto d = std::div(beat * fpb_n, fpb_d); // std::div() isn't constexpr at this time.
 	if (d.rem > 0) d.quot++; else if (d.rem < 0) d.quot--;
 	return static_cast<int32_t>(d.quot) + origin;
 }
+
+// フレーム範囲 [pos_L, pos_R] にある拍数線を左から順に列挙する．
+expt::BPM_Grid::line_range expt::BPM_Grid::lines_in(int32_t pos_L, int32_t pos_R, int subdiv) const
+{
+	if (!*this || subdiv <= 0 || pos_L > pos_R) return { line_iterator::none() };
+	return { line_iterator::first_in(fpb_n, fpb_d * subdiv, origin, pos_L, pos_R) };
+}
+
+// 区間をつないだ BPM グリッド．
+int64_t expt::TempoGrid::beat_from_pos(int32_t pos) const
+{
+	if (pieces.empty()) return 0;
+
+	// find the last piece beginning at or before `pos`.
+	auto it = std::ranges::upper_bound(pieces, pos, {}, [](auto const& p) { return p.grid.origin; });
+	if (it != pieces.begin()) --it;
+	return it->first_beat + it->grid.beat_from_pos(pos);
+}
+
+int32_t expt::TempoGrid::pos_from_beat(int64_t beat) const
+{
+	if (pieces.empty()) return 0;
+
+	// find the last piece beginning at or before `beat`.
+	auto it = std::ranges::upper_bound(pieces, beat, {}, &piece::first_beat);
+	if (it != pieces.begin()) --it;
+	return it->grid.pos_from_beat(beat - it->first_beat);
+}
+
+expt::TempoGrid::line_range expt::TempoGrid::lines_in(int32_t pos_L, int32_t pos_R, int subdiv) const
+{
+	line_iterator it{};
+	it.next = it.last = pieces.data() + pieces.size();
+	if (pieces.empty()) {
+		it.curr = BPM_Grid{ 0, 0, 0, 0, 0, 0 }.lines_in(0, -1).first; // an empty range.
+		return { it };
+	}
+
+	// start from the piece that contains `pos_L`.
+	auto const curr = std::ranges::upper_bound(pieces, pos_L, {}, [](auto const& p) { return p.grid.origin; });
+	auto const& p = curr != pieces.begin() ? curr[-1] : pieces.front();
+	it.curr = p.grid.lines_in(pos_L, pos_R, subdiv).first;
+	it.base = p.first_beat * subdiv;
+	it.next = &p + 1;
+	it.pos_R = pos_R; it.subdiv = subdiv;
+	it.settle();
+	return { it };
+}
+
+void expt::TempoGrid::line_iterator::settle()
+{
+	while (next != last && curr != std::default_sentinel && (*curr).pos >= next->grid.origin) {
+		curr = next->grid.lines_in(next->grid.origin, pos_R, subdiv).first;
+		base = next->first_beat * subdiv;
+		++next;
+	}
+}
@@ -14,6 +14,8 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 
 #include <cstdint>
 #include <algorithm>
+#include <iterator>
+#include <vector>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -22,6 +24,8 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 using byte = uint8_t;
 #include <exedit.hpp>
 
+#include "beat_lines.hpp"
+
 
 ////////////////////////////////
 // BPM グリッドの丸め計算．
@@ -33,6 +37,8 @@ namespace enhanced_tl::BPM_Grid
 		BPM_Grid(int origin, int beats_numer, int beats_denom);
 		/// @brief `origin` を現在の拡張編集の設定値として初期化．
 		BPM_Grid(int beats_numer, int beats_denom);
+		/// @brief フレームレート (`video_rate / video_scale`) とテンポ (BPM の 10'000 倍) を指定して初期化．
+		BPM_Grid(int origin, int beats_numer, int beats_denom, int video_rate, int video_scale, int tempo);
 
 		/// @brief 正しく初期化されたかどうかをチェック．
 		constexpr operator bool() const { return fpb_n > 0 && fpb_d > 0; }
@@ -45,11 +51,101 @@ namespace enhanced_tl::BPM_Grid
 		/// @brief 拍数からフレーム位置を計算．拍数 `beat` で描画される拍数線のフレーム位置を返す．
 		int32_t pos_from_beat(int64_t beat) const;
 
+		/// @brief 拍数線 1 本分の情報．
+		using line = beat_lines::line;
+
+		/// @brief 拍数線を左から順に列挙するイテレータ．
+		using line_iterator = beat_lines::line_iterator;
+
+		/// @brief `lines_in()` の戻り値．範囲 for 文で使う．
+		struct line_range {
+			line_iterator first;
+			line_iterator begin() const { return first; }
+			std::default_sentinel_t end() const { return {}; }
+			bool empty() const { return first == end(); }
+		};
+
+		/// @brief フレーム範囲 `[pos_L, pos_R]` にある拍数線を左から順に列挙する．
+		/// @param subdiv 拍数線の間をさらに等分する数．`line::beat` はこの細分化した線の通し番号になる．
+		line_range lines_in(int32_t pos_L, int32_t pos_R, int subdiv = 1) const;
+
 		// the origin of the BPM grid.
 		int32_t origin;
 
 	private:
 		// "frames per beat" represented as a rational number.
 		int64_t fpb_n, fpb_d;
+
+		// initializes with the frame rate of the given file info.
+		BPM_Grid(int origin, int beats_numer, int beats_denom, AviUtl::FileInfo const& fi);
 	};
+
+	// テンポマップに沿って区間ごとの `BPM_Grid` をつないだもの．
+	struct TempoGrid {
+		/// @brief 区間 1 つ分．区間の開始フレーム `grid.origin` に拍数 `first_beat` の線がある．
+		/// 最初の区間は左方向に，最後の区間は右方向に際限なく続く．
+		struct piece {
+			BPM_Grid grid;
+			int64_t first_beat;
+		};
+		// sorted by `grid.origin`, and so by `first_beat`.
+		std::vector<piece> pieces;
+
+		/// @brief 正しく初期化されたかどうかをチェック．
+		operator bool() const { return !pieces.empty(); }
+
+		/// @brief フレーム位置から拍数を計算．`BPM_Grid::beat_from_pos()` の区間つなぎ版．
+		int64_t beat_from_pos(int32_t pos) const;
+
+		/// @brief 拍数からフレーム位置を計算．`BPM_Grid::pos_from_beat()` の区間つなぎ版．
+		int32_t pos_from_beat(int64_t beat) const;
+
+		/// @brief 拍数線を左から順に列挙するイテレータ．区間の境目でだけ除算をやり直す．
+		struct line_iterator {
+			using value_type = BPM_Grid::line;
+			using difference_type = std::ptrdiff_t;
+
+			BPM_Grid::line operator*() const { auto [beat, pos] = *curr; return { beat + base, pos }; }
+			line_iterator& operator++() { ++curr; settle(); return *this; }
+			line_iterator operator++(int) { auto ret = *this; ++*this; return ret; }
+			bool operator==(std::default_sentinel_t) const { return curr == std::default_sentinel; }
+
+		private:
+			friend TempoGrid;
+			BPM_Grid::line_iterator curr;
+			// the beat number of the first line in the current piece.
+			int64_t base;
+			piece const* next; piece const* last;
+			int32_t pos_R; int subdiv;
+
+			// moves on to the next piece once the lines reach its beginning.
+			void settle();
+		};
+
+		/// @brief `lines_in()` の戻り値．範囲 for 文で使う．
+		struct line_range {
+			line_iterator first;
+			line_iterator begin() const { return first; }
+			std::default_sentinel_t end() const { return {}; }
+			bool empty() const { return first == end(); }
+		};
+
+		/// @brief フレーム範囲 `[pos_L, pos_R]` にある拍数線を左から順に列挙する．`BPM_Grid::lines_in()` の区間つなぎ版．
+		/// `subdiv` が 2 以上のとき，区間の境目で `line::beat` の番号が飛ぶことがある．
+		line_range lines_in(int32_t pos_L, int32_t pos_R, int subdiv = 1) const;
+	};
+
+	/// @brief 現在の拡張編集の設定値とテンポマップで初期化した `TempoGrid` を取得．
+	/// 設定値が前回の呼び出しから変わっていなければ，同じものを返す．
+	/// @param beats_numer 拍数線の間隔を拍数で表した分子．負の値 `-N` は N 小節を表す．
+	/// @return 次に呼び出すまで有効な参照．
+	TempoGrid const& current_grid(int beats_numer, int beats_denom);
+
+	/// @brief 現在の編集ファイルにテンポマップがあるかどうか．
+	/// あれば `current_grid()` は拡張編集の BPM と基準フレームの設定値を使わない．
+	bool has_tempo_map();
+
+	/// @brief `current_grid()` が保持しているフレームレートとテンポマップを破棄する．
+	/// 編集ファイルが変わったときに呼ぶ．
+	void invalidate_file_info();
 }
@@ -13,7 +13,8 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 #include <cstdint>
 #include <tuple>
 #include <vector>
-#include <set>
+#include <cstring>
+#include <string_view>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -31,6 +32,9 @@ using byte = uint8_t;
 #include "mouse_override.hpp"
 #include "context_menu.hpp"
 #include "tooltip.hpp"
+#include "bpm_grid.hpp"
+#include "audio_peaks.hpp"
+#include "markers.hpp"
 
 
 ////////////////////////////////
@@ -72,18 +76,15 @@ bool is_editing(AviUtl::EditHandle* editp)
 }
 
 // 複数選択オブジェクトの取得．
-std::set<int32_t> get_multi_selected_objects()
+enhanced_tl::object_selection get_multi_selected_objects()
 {
-	// store the selected index to std::set<int32_t>.
-	return { exedit.SelectedObjectIndex, exedit.SelectedObjectIndex + *exedit.SelectedObjectNum_ptr };
+	return enhanced_tl::object_selection::current();
 }
 
 // 複数選択オブジェクトの設定．
-void set_multi_selected_objects(std::set<int32_t> const& sel)
+void set_multi_selected_objects(enhanced_tl::object_selection const& sel)
 {
-	// copy back the selected index to exedit.
-	std::copy(sel.begin(), sel.end(), exedit.SelectedObjectIndex);
-	*exedit.SelectedObjectNum_ptr = sel.size();
+	sel.write_back();
 }
 
 // 設定ダイアログのデータ表示を更新．
@@ -130,6 +131,28 @@ void update_current_frame()
 	::PostMessageW(exedit.fp->hwnd, msg_update_main, 0, 0);
 }
 
+// プロジェクトファイルに付随するファイルのパス．
+bool project_sidecar_path(char(&buf)[MAX_PATH], std::string_view ext)
+{
+	buf[0] = '\0';
+
+	AviUtl::SysInfo si{};
+	if (*exedit.editp == nullptr ||
+		exedit.fp->exfunc->get_sys_info(*exedit.editp, &si) == FALSE ||
+		si.project_name == nullptr || si.project_name[0] == '\0') return false;
+
+	// replace the extension.
+	std::string_view stem = si.project_name;
+	if (auto const dot = stem.find_last_of('.');
+		dot != stem.npos && dot > stem.find_last_of("\\/") + 1) stem = stem.substr(0, dot);
+	if (stem.size() + ext.size() >= std::size(buf)) return false;
+
+	std::memcpy(buf, stem.data(), stem.size());
+	std::memcpy(buf + stem.size(), ext.data(), ext.size());
+	buf[stem.size() + ext.size()] = '\0';
+	return true;
+}
+
 // 競合通知メッセージ．
 bool warn_conflict(wchar_t const* module_name, wchar_t const* ini_piece)
 {
@@ -272,9 +295,28 @@ static BOOL func_WndProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam,
 		char ini_file[MAX_PATH];
 		replace_tail(ini_file, ::GetModuleFileNameA(fp->dll_hinst, ini_file, std::size(ini_file)) + 1, "auf", "ini");
 		enhanced_tl::layer_resize::settings.save(ini_file);
+
+		enhanced_tl::walkaround::discard_pending_moves();
+		enhanced_tl::walkaround::close_history();
+		enhanced_tl::markers::close();
+		enhanced_tl::audio_peaks::unload();
 		break;
 	}
 
+		// 編集ファイルが変わるとフレームレートやテンポマップも変わりうる．
+	case Message::FileOpen:
+	case Message::FileClose:
+		enhanced_tl::walkaround::discard_pending_moves();
+		enhanced_tl::walkaround::close_history();
+		enhanced_tl::markers::close();
+		enhanced_tl::audio_peaks::unload();
+		[[fallthrough]];
+	case Message::FileUpdate:
+	{
+		enhanced_tl::BPM_Grid::invalidate_file_info();
+		return enhanced_tl::layer_resize::on_wnd_proc(hwnd, message, wparam, lparam);
+	}
+
 	case PrivateMsg::RequestCallback:
 	{
 		if (auto const callback = reinterpret_cast<PrivateMsg::callback_fnptr>(lparam);
@@ -14,7 +14,7 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 
 #include <cstdint>
 #include <vector>
-#include <set>
+#include <string_view>
 #include <bit>
 #include <concepts>
 
@@ -26,6 +26,7 @@ using byte = uint8_t;
 #include <exedit.hpp>
 
 #include "modkeys.hpp"
+#include "selection.hpp"
 
 
 ////////////////////////////////
@@ -254,10 +255,10 @@ bool is_editing();
 bool is_editing(AviUtl::EditHandle* editp);
 
 // 複数選択オブジェクトの取得．
-std::set<int32_t> get_multi_selected_objects();
+enhanced_tl::object_selection get_multi_selected_objects();
 
 // 複数選択オブジェクトの設定．
-void set_multi_selected_objects(std::set<int32_t> const& sel);
+void set_multi_selected_objects(enhanced_tl::object_selection const& sel);
 
 // 設定ダイアログのデータ表示を更新．
 void update_setting_dialog(int index);
@@ -265,6 +266,10 @@ void update_setting_dialog(int index);
 // 編集データの変更でメイン画面を更新．
 void update_current_frame();
 
+// プロジェクトファイルの拡張子を `ext` に置き換えたパス．
+// プロジェクトファイルが未保存などで求まらない場合は `false` を返し，`buf` は空文字列になる．
+bool project_sidecar_path(char(&buf)[MAX_PATH], std::string_view ext);
+
 template<class ExDataT>
 inline ExDataT* find_exdata(ptrdiff_t obj_exdata_offset, ptrdiff_t filter_exdata_offset) {
 	return reinterpret_cast<ExDataT*>((*exedit.exdata_table)
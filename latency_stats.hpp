@@ -0,0 +1,54 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+
+////////////////////////////////
+// キー操作の遅延の集計 (Windows に依存しない部分)．
+////////////////////////////////
+namespace enhanced_tl::walkaround
+{
+	// キー操作からその結果の適用までの遅延の集計．
+	// 間隔が `burst_gap_ms` 未満で続く一連の操作ごとに数え直すので，
+	// 操作が途切れた後の `last_lag` がキーを離してから落ち着くまでの時間の目安になる．
+	struct latency_stats {
+		constexpr static int burst_gap_ms = 250;
+
+		int32_t num_commands = 0, num_applied = 0;
+		int32_t last_lag = 0, max_lag = 0;
+		int last_command = 0;
+
+		/// @brief コマンドを受け取ったときに呼ぶ．
+		/// @param now 現在時刻 (ミリ秒)．
+		constexpr void on_command(int now)
+		{
+			if (num_commands > 0 && now - last_command >= burst_gap_ms) *this = {};
+			num_commands++;
+			last_command = now;
+		}
+
+		/// @brief コマンドの結果を適用したときに呼ぶ．
+		/// @param msg_time 最後に受け取ったコマンドのメッセージが送られた時刻 (ミリ秒)．
+		/// @param now 現在時刻 (ミリ秒)．
+		constexpr void on_applied(int msg_time, int now)
+		{
+			num_applied++;
+			last_lag = std::max(now - msg_time, 0);
+			max_lag = std::max(max_lag, last_lag);
+		}
+	};
+}
@@ -0,0 +1,224 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+using byte = uint8_t;
+#include <exedit.hpp>
+
+#include "enhanced_tl.hpp"
+#include "timeline.hpp"
+#include "markers.hpp"
+
+
+#define NS_BEGIN(...) namespace __VA_ARGS__ {
+#define NS_END }
+NS_BEGIN()
+
+////////////////////////////////
+// マーカーの保持と保存．
+////////////////////////////////
+namespace tlc = enhanced_tl::timeline::constants;
+
+// ファイルの先頭に置く情報．この後にシーンごとに
+// { int32_t scene, count; int32_t frames[count]; } が並ぶ．
+struct file_header {
+	constexpr static uint32_t
+		magic_value = 'E' | ('T' << 8) | ('M' << 16) | ('K' << 24),
+		version_value = 1;
+
+	uint32_t magic, version;
+	int32_t num_scenes;
+};
+
+// シーンごとに昇順に並べたマーカー位置．
+// プロジェクトファイルに付随する "<プロジェクト名>.markers.bin" と同期する．
+#ifdef NDEBUG
+constinit
+#endif
+static struct {
+	std::vector<int32_t> by_scene[tlc::num_scenes];
+	char path[MAX_PATH];
+	bool dirty;
+} state{};
+
+static void load()
+{
+	for (auto& v : state.by_scene) v.clear();
+	state.dirty = false;
+	if (state.path[0] == '\0') return;
+
+	// read the entire file at once.
+	auto const file = ::CreateFileA(state.path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+
+	std::vector<int32_t> buf;
+	constexpr int64_t max_file_size = 1 << 26;
+	if (LARGE_INTEGER size{};
+		::GetFileSizeEx(file, &size) != FALSE &&
+		size.QuadPart % sizeof(int32_t) == 0 && size.QuadPart <= max_file_size) {
+		buf.resize(static_cast<size_t>(size.QuadPart / sizeof(int32_t)));
+		DWORD read = 0;
+		if (::ReadFile(file, buf.data(), static_cast<DWORD>(size.QuadPart), &read, nullptr) == FALSE ||
+			read != size.QuadPart) buf.clear();
+	}
+	::CloseHandle(file);
+
+	// validate the header.
+	constexpr size_t header_len = sizeof(file_header) / sizeof(int32_t);
+	file_header h{};
+	if (buf.size() < header_len) return;
+	std::memcpy(&h, buf.data(), sizeof(h));
+	if (h.magic != file_header::magic_value ||
+		h.version != file_header::version_value ||
+		h.num_scenes < 0 || h.num_scenes > tlc::num_scenes) return;
+
+	// copy the frames of each scene, which are stored in order.
+	for (size_t i = header_len, n = 0; n < static_cast<size_t>(h.num_scenes); n++) {
+		if (i + 2 > buf.size()) break;
+		int32_t const scene = buf[i], count = buf[i + 1];
+		i += 2;
+		if (scene < 0 || scene >= tlc::num_scenes ||
+			count < 0 || static_cast<size_t>(count) > buf.size() - i) break;
+
+		auto const first = buf.begin() + i, last = first + count;
+		i += count;
+		if (std::adjacent_find(first, last, std::greater_equal<>{}) != last ||
+			(count > 0 && *first < 0)) continue; // broken data.
+
+		state.by_scene[scene].assign(first, last);
+	}
+}
+
+static void save()
+{
+	if (!std::exchange(state.dirty, false) || state.path[0] == '\0') return;
+
+	// build the whole image first.
+	std::vector<int32_t> buf(sizeof(file_header) / sizeof(int32_t));
+	int32_t num_scenes = 0;
+	for (int scene = 0; scene < tlc::num_scenes; scene++) {
+		auto const& v = state.by_scene[scene];
+		if (v.empty()) continue;
+
+		buf.push_back(scene);
+		buf.push_back(static_cast<int32_t>(v.size()));
+		buf.insert(buf.end(), v.begin(), v.end());
+		num_scenes++;
+	}
+
+	// an empty set of markers removes the file.
+	if (num_scenes == 0) {
+		::DeleteFileA(state.path);
+		return;
+	}
+
+	file_header const h{ file_header::magic_value, file_header::version_value, num_scenes };
+	std::memcpy(buf.data(), &h, sizeof(h));
+
+	auto const file = ::CreateFileA(state.path, GENERIC_WRITE, 0, nullptr,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+	DWORD written;
+	::WriteFile(file, buf.data(), static_cast<DWORD>(buf.size() * sizeof(int32_t)), &written, nullptr);
+	::CloseHandle(file);
+}
+
+// switches to the markers of the current project if necessary.
+static void sync()
+{
+	char curr[MAX_PATH];
+	project_sidecar_path(curr, ".markers.bin");
+	if (std::strcmp(curr, state.path) == 0) return;
+
+	// keep the markers made before the project was first saved.
+	if (state.path[0] == '\0' && state.dirty) {
+		std::strcpy(state.path, curr);
+		return;
+	}
+
+	save();
+	std::strcpy(state.path, curr);
+	load();
+}
+
+static std::vector<int32_t>& current()
+{
+	sync();
+	return state.by_scene[std::clamp(*exedit.current_scene, 0, tlc::num_scenes - 1)];
+}
+
+NS_END
+
+
+////////////////////////////////
+// exported functions.
+////////////////////////////////
+namespace expt = enhanced_tl::markers;
+
+std::optional<int32_t> expt::find_left(int32_t pos)
+{
+	auto const& v = current();
+	auto const it = std::lower_bound(v.begin(), v.end(), pos);
+	if (it == v.begin()) return std::nullopt;
+	return *(it - 1);
+}
+
+std::optional<int32_t> expt::find_right(int32_t pos)
+{
+	auto const& v = current();
+	auto const it = std::upper_bound(v.begin(), v.end(), pos);
+	if (it == v.end()) return std::nullopt;
+	return *it;
+}
+
+bool expt::toggle(int32_t pos)
+{
+	auto& v = current();
+	state.dirty = true;
+	if (auto const it = std::lower_bound(v.begin(), v.end(), pos);
+		it != v.end() && *it == pos) {
+		v.erase(it);
+		return false;
+	}
+	else {
+		v.insert(it, pos);
+		return true;
+	}
+}
+
+bool expt::clear_scene()
+{
+	auto& v = current();
+	if (v.empty()) return false;
+
+	v.clear();
+	state.dirty = true;
+	return true;
+}
+
+void expt::close()
+{
+	save();
+	for (auto& v : state.by_scene) v.clear();
+	state.path[0] = '\0';
+}
@@ -0,0 +1,49 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+
+////////////////////////////////
+// シーンごとのマーカー．
+////////////////////////////////
+namespace enhanced_tl::markers
+{
+	/// @brief 現在のシーンで，指定位置より左にある最も近いマーカーを探す．
+	/// @param pos 検索を始めるフレーム位置．この位置自身は対象外．
+	/// @return 見つかったフレーム位置．見つからない場合は `std::nullopt`.
+	std::optional<int32_t> find_left(int32_t pos);
+
+	/// @brief 現在のシーンで，指定位置より右にある最も近いマーカーを探す．
+	/// @param pos 検索を始めるフレーム位置．この位置自身は対象外．
+	/// @return 見つかったフレーム位置．見つからない場合は `std::nullopt`.
+	std::optional<int32_t> find_right(int32_t pos);
+
+	/// @brief 現在のシーンの指定位置にマーカーがなければ追加し，あれば削除する．
+	/// @param pos マーカーのフレーム位置．
+	/// @return マーカーを追加した場合は `true`, 削除した場合は `false`.
+	bool toggle(int32_t pos);
+
+	/// @brief 現在のシーンのマーカーをすべて削除する．
+	/// @return 削除したマーカーがあった場合は `true`.
+	bool clear_scene();
+
+	/// @brief マーカーをプロジェクトファイルに付随するファイルに保存し，メモリ上から破棄する．
+	void close();
+}
@@ -102,6 +102,7 @@ static inline drag_state* map_drag(mouse_button btn, int x, int y, modkeys mkeys
 		case zoom_bi:		return &timeline::drags::zoom_bi;
 		case step_bound:	return &timeline::drags::step_bound;
 		case step_bpm:		return &timeline::drags::step_bpm;
+		case step_marker:	return &timeline::drags::step_marker;
 
 		case bypass: return nullptr;
 		}
@@ -197,6 +198,8 @@ static inline click_func* map_click(mouse_button btn, bool is_double, int x, int
 		case select_all:		return &timeline::clicks::select_all;
 		case squeeze_left:		return &timeline::clicks::squeeze_left;
 		case squeeze_right:		return &timeline::clicks::squeeze_right;
+		case ripple_delete:		return &timeline::clicks::ripple_delete;
+		case ripple_insert:		return &timeline::clicks::ripple_insert;
 		case toggle_active:		return &timeline::clicks::toggle_active;
 
 		case bypass: return nullptr;
@@ -314,6 +317,10 @@ static inline std::pair<wheel_func*, bool> map_wheel(bool r_button, int client_x
 		case move_bpm_p: case move_bpm_n:
 			return { &timeline::wheels::step_bpm_grid,		action == move_bpm_n };
 
+			// moving frame to the markers.
+		case move_marker_p: case move_marker_n:
+			return { &timeline::wheels::step_marker,		action == move_marker_n };
+
 		case change_scene_p: case change_scene_n:
 			return { &timeline::wheels::change_scene,		action == change_scene_n };
 
@@ -690,7 +697,7 @@ void expt::Settings::load(char const* ini_file)
 
 	constexpr int
 		drag_len_min = -200, drag_len_max = 200,
-		drag_ref_min = 1, drag_ref_max = std::max(-drag_len_min, drag_len_max);
+		drag_ref_min = 0, drag_ref_max = std::max(-drag_len_min, drag_len_max);
 	read(bool,	timeline, enabled);
 	read(bool,	timeline, change_cursor);
 	read(bool,	timeline, wheel_vertical_scrollbar);
@@ -699,6 +706,7 @@ void expt::Settings::load(char const* ini_file)
 	read(int,	timeline, zoom_drag_refine_x, drag_ref_min, drag_ref_max);
 	read(int,	timeline, zoom_drag_length_x, drag_len_min, drag_len_max);
 	read(int,	timeline, zoom_drag_length_y, drag_len_min, drag_len_max);
+	read(bool,	timeline, zoom_wheel_smooth);
 	read(modkey,timeline, skip_midpt_key);
 	read(bool,	timeline, skip_midpt_def);
 	read(modkey,timeline, skip_inactives_key);
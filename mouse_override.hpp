@@ -59,6 +59,7 @@ namespace enhanced_tl::mouse_override
 					zoom_bi		= 100,
 					step_bound	= 101,
 					step_bpm	= 102,
+					step_marker	= 103,
 
 					bypass = 255,
 				};
@@ -79,6 +80,8 @@ namespace enhanced_tl::mouse_override
 					squeeze_left		= 110,
 					squeeze_right		= 111,
 					toggle_active		= 112,
+					ripple_delete		= 113,
+					ripple_insert		= 114,
 
 					bypass = 255,
 				};
@@ -99,6 +102,7 @@ namespace enhanced_tl::mouse_override
 					move_midpt_all_p	= 111,	move_midpt_all_n	= 112,
 					move_obj_all_p		= 113,	move_obj_all_n		= 114,
 					move_bpm_p			= 115,	move_bpm_n			= 116,
+					move_marker_p		= 117,	move_marker_n		= 118,
 					change_scene_p		= 121,	change_scene_n		= 122,
 
 					bypass = 255,
@@ -152,9 +156,10 @@ namespace enhanced_tl::mouse_override
 			bool wheel_vertical_scrollbar	= true;
 			tl_zoom_center zoom_center_wheel = tl_zoom_center::mouse;
 			tl_zoom_center zoom_center_drag = tl_zoom_center::window_left;
-			uint8_t zoom_drag_refine_x		= 8;
+			uint8_t zoom_drag_refine_x		= 8; // if zero, continuous zoom.
 			int16_t zoom_drag_length_x		= 64; // if zero, no change along that axis.
 			int16_t zoom_drag_length_y		= 16; // if zero, no change along that axis.
+			bool zoom_wheel_smooth			= false;
 			modkeys skip_midpt_key			= modkeys::shift;
 			bool skip_midpt_def				= true;
 			modkeys skip_inactives_key		= modkeys::none;
@@ -12,7 +12,9 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 
 #include <cstdint>
 #include <cmath>
-#include <set>
+#include <cassert>
+#include <algorithm>
+#include <vector>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -23,6 +25,7 @@ using byte = uint8_t;
 
 #include "../modkeys.hpp"
 #include "../timeline.hpp"
+#include "../timeline_index.hpp"
 #include "../walkaround.hpp"
 #include "mouse_actions.hpp"
 
@@ -166,7 +169,7 @@ static int find_layer_and_scroll(int client_y, enhanced_tl::mouse_override::drag
 	return layer_curr;
 }
 
-static bool add_selection(int layer, std::set<int32_t>& sel)
+static bool add_selection(int layer, enhanced_tl::object_selection& sel)
 {
 	// avoid selecting objects in locked layers.
 	auto* const layer_settings = exedit.LayerSettings + tl::constants::num_layers * *exedit.current_scene;
@@ -176,17 +179,68 @@ static bool add_selection(int layer, std::set<int32_t>& sel)
 	bool ret = false;
 	int const L = exedit.SortedObjectLayerBeginIndex[layer], R = exedit.SortedObjectLayerEndIndex[layer];
 	for (int j = L; j <= R; j++)
-		ret |= sel.insert(exedit.SortedObject[j] - *exedit.ObjectArray_ptr).second;
+		ret |= sel.insert(exedit.SortedObject[j] - *exedit.ObjectArray_ptr);
 	return ret;
 }
-static bool remove_selection(int layer, std::set<int32_t>& sel)
+static bool remove_selection(int layer, enhanced_tl::object_selection& sel)
 {
 	bool ret = false;
 	int const L = exedit.SortedObjectLayerBeginIndex[layer], R = exedit.SortedObjectLayerEndIndex[layer];
 	for (int j = L; j <= R; j++)
-		ret |= sel.erase(exedit.SortedObject[j] - *exedit.ObjectArray_ptr) != 0;
+		ret |= sel.erase(exedit.SortedObject[j] - *exedit.ObjectArray_ptr);
 	return ret;
 }
+
+// レイヤー `from` の中身を `to` へ移し，間のレイヤーを 1 つずつ詰めた後の索引表を，
+// `exedit.update_object_tables()` で全体を作り直さずに直接書き換える．
+// オブジェクトの `layer_disp` と `layer_set` は書き換え済みであること．
+// 索引表が想定どおりの形でない場合は何もせず `false` を返す．
+static bool rotate_layer_tables(int from, int to)
+{
+	int const lo = std::min(from, to), hi = std::max(from, to);
+	auto* const begins = exedit.SortedObjectLayerBeginIndex;
+	auto* const ends = exedit.SortedObjectLayerEndIndex;
+
+	// the ranges of the layers must tile a contiguous block, empty layers included.
+	if (begins[lo] < 0) return false;
+	for (int l = lo; l <= hi; l++) {
+		if (ends[l] < begins[l] - 1 ||
+			(l > lo && begins[l] != ends[l - 1] + 1)) return false;
+	}
+
+	// move the objects of `from` to the other end of the block.
+	auto* const sorted = exedit.SortedObject;
+	int const first = begins[lo], last = ends[hi] + 1;
+	std::rotate(sorted + first, sorted + (from < to ? begins[lo + 1] : begins[hi]), sorted + last);
+
+	// re-assign the ranges in the new order of layers.
+	int sizes[tl::constants::num_layers];
+	for (int l = lo; l <= hi; l++) sizes[l] = ends[l] - begins[l] + 1;
+	std::rotate(sizes + lo, sizes + (from < to ? lo + 1 : hi), sizes + hi + 1);
+	for (int l = lo, pos = first; l <= hi; l++) {
+		begins[l] = pos;
+		pos += sizes[l];
+		ends[l] = pos - 1;
+	}
+
+#ifndef NDEBUG
+	// compare with the full rebuild.
+	int len = 0;
+	for (int l = 0; l < tl::constants::num_layers; l++) len = std::max(len, ends[l] + 1);
+	std::vector<ExEdit::Object*> const patched_objects{ sorted, sorted + len };
+	std::vector<int32_t> const
+		patched_begins{ begins + lo, begins + hi + 1 },
+		patched_ends{ ends + lo, ends + hi + 1 };
+	exedit.update_object_tables();
+	assert(std::equal(patched_objects.begin(), patched_objects.end(), sorted));
+	for (int l = lo; l <= hi; l++) {
+		// empty layers may differ in their representation.
+		if (ends[l] >= begins[l])
+			assert(patched_begins[l - lo] == begins[l] && patched_ends[l - lo] == ends[l]);
+	}
+#endif
+	return true;
+}
 NS_END
 
 
@@ -227,7 +281,9 @@ bool expt::drags::detail::flag_drag::on_mouse_down_core(modkeys mkeys)
 	prev_scene = *exedit.current_scene;
 
 	// modify the first flag.
+	// the cached layer states share the undo step, so discard them on each change.
 	f ^= flag();
+	tl::index::invalidate();
 
 	scroll_timer.kill(); // reset the timer.
 	::SetCapture(exedit.fp->hwnd);
@@ -260,6 +316,8 @@ bool expt::drags::detail::flag_drag::on_mouse_move_core(modkeys mkeys)
 	}
 
 	if (modified) {
+		tl::index::invalidate();
+
 		// redraw the entire timeline.
 		::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
 		return redraw();
@@ -275,6 +333,7 @@ bool expt::drags::detail::flag_drag::on_mouse_up_core(modkeys mkeys)
 bool expt::drags::detail::flag_drag::on_mouse_cancel_core(bool release)
 {
 	scroll_timer.kill();
+	tl::index::invalidate();
 	if (release) ::ReleaseCapture();
 	return false;
 }
@@ -455,8 +514,12 @@ bool expt::drags::Drag_Move::on_mouse_move_core(modkeys mkeys)
 	}
 	layer_settings[layer_curr] = settings_src;
 
-	// re-construct internal object tables.
-	if (modified) exedit.update_object_tables();
+	// re-construct internal object tables, by patching the affected ranges if possible.
+	if (modified) {
+		if (!rotate_layer_tables(from, layer_curr))
+			exedit.update_object_tables();
+		tl::index::invalidate();
+	}
 
 	// redraw the entire timeline. (cannot skip as layer settings might have changed.)
 	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
@@ -466,12 +529,23 @@ bool expt::drags::Drag_Move::on_mouse_up_core(modkeys mkeys)
 {
 	scroll_timer.kill();
 	::ReleaseCapture();
+
+	// rebuild the tables once to make sure every other internal data of exedit is settled.
+	if (flag_value) {
+		exedit.update_object_tables();
+		tl::index::invalidate();
+	}
 	return true; // update the main window at the end of the drag.
 }
 bool expt::drags::Drag_Move::on_mouse_cancel_core(bool release)
 {
 	scroll_timer.kill();
 	if (release) ::ReleaseCapture();
+
+	if (flag_value) {
+		exedit.update_object_tables();
+		tl::index::invalidate();
+	}
 	return true;
 }
 
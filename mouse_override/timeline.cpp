@@ -13,7 +13,9 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 #include <cstdint>
 #include <cmath>
 #include <tuple>
-#include <set>
+#include <limits>
+#include <algorithm>
+#include <vector>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -25,6 +27,7 @@ using byte = uint8_t;
 #include "../key_states.hpp"
 #include "../modkeys.hpp"
 #include "../timeline.hpp"
+#include "../timeline_index.hpp"
 #include "mouse_actions.hpp"
 
 #include "../enhanced_tl.hpp"
@@ -32,6 +35,7 @@ using byte = uint8_t;
 #include "../layer_resize.hpp"
 #include "../walkaround.hpp"
 #include "../bpm_grid.hpp"
+#include "../markers.hpp"
 
 #include "timeline.hpp"
 
@@ -50,66 +54,151 @@ namespace tl = enhanced_tl::timeline;
 namespace wa = enhanced_tl::walkaround;
 namespace lr = enhanced_tl::layer_resize::internal;
 
-// smooth horizontal zoom by drags::Zoom_Bi.
+// continuous horizontal zoom, by drags::Zoom_Bi and wheels::zoom_h.
+// the zoom length can take any value between the shortest and the longest in the table,
+// and the scroll position is computed from the pivot on each change, so errors don't build up.
 namespace smooth_zoom
 {
-	static int center_frame{}, center_point{};
+	constexpr int level_frac_bits = 16, scroll_frac_bits = 16;
+	constexpr int32_t level_one = 1 << level_frac_bits;
+	constexpr int32_t max_level = level_one * (tl::constants::num_zoom_levels - 1);
+
+	// the frame kept at the same position, and the state when it was set.
+	static int32_t pivot_frame{}, pivot_scroll{}, pivot_len{};
 	static void pivot(int frame) {
-		// to address cummulative error.
-		smooth_zoom::center_frame = frame;
-		smooth_zoom::center_point = tl::point_from_frame(frame);
+		pivot_frame = frame;
+		pivot_scroll = *exedit.timeline_h_scroll_pos;
+		pivot_len = std::max(*exedit.curr_timeline_zoom_len, 1);
 	}
 
-	// identifies "refined" zoom level at the current state.
-	static int get(int divs)
+	// converts the zoom length to the level, in the fixed point with `level_frac_bits`.
+	// lengths between two levels in the table are interpolated linearly.
+	static int32_t level_from_len(int32_t len)
 	{
-		int32_t const len = *exedit.curr_timeline_zoom_len;
-
-		// identify the "raw" zoom level.
-		int m = 0;
-		for (int M = tl::constants::num_zoom_levels - 1; m < M;) {
-			int const k = (M + m) >> 1;
-			if (len >= exedit.timeline_zoom_lengths[k + 1])
-				m = k + 1;
-			else M = k;
-		}
-		if (m >= tl::constants::num_zoom_levels - 1) return divs * (tl::constants::num_zoom_levels - 1);
+		auto const* const lengths = exedit.timeline_zoom_lengths;
+		if (len <= lengths[0]) return 0;
+		if (len >= lengths[tl::constants::num_zoom_levels - 1]) return max_level;
+
+		int const m = static_cast<int>(std::upper_bound(lengths, lengths + tl::constants::num_zoom_levels, len) - lengths) - 1;
+		int64_t const dlen = lengths[m + 1] - lengths[m];
+		return m * level_one + static_cast<int32_t>(((int64_t{ len - lengths[m] } << level_frac_bits) + (dlen >> 1)) / dlen);
+	}
+	static int32_t len_from_level(int32_t level)
+	{
+		auto const* const lengths = exedit.timeline_zoom_lengths;
+		level = std::clamp(level, 0, max_level);
+		int const m = level >> level_frac_bits;
+		if (m >= tl::constants::num_zoom_levels - 1) return lengths[m];
 
-		// divide the interval by `divs` sections.
-		int const dlen = exedit.timeline_zoom_lengths[m + 1] - exedit.timeline_zoom_lengths[m];
-		int const dlev = std::clamp(((len - exedit.timeline_zoom_lengths[m]) * divs + (dlen >> 1)) / dlen, 0, divs);
-		return m * divs + dlev;
+		int64_t const dlen = lengths[m + 1] - lengths[m], f = level & (level_one - 1);
+		return lengths[m] + static_cast<int32_t>((dlen * f + (level_one >> 1)) >> level_frac_bits);
 	}
+	static int32_t get() { return level_from_len(*exedit.curr_timeline_zoom_len); }
 
-	// applies "refined" zoom level.
-	static void set(int level, int divs)
+	// applies the zoom length, keeping the pivot frame at its position.
+	static void set_len(int32_t len)
 	{
-		int32_t const len = *exedit.curr_timeline_zoom_len;
+		auto const* const lengths = exedit.timeline_zoom_lengths;
+		len = std::clamp(len, lengths[0], lengths[tl::constants::num_zoom_levels - 1]);
+		if (len == *exedit.curr_timeline_zoom_len) return; // no need to modify.
+
+		// the pivot stays at the same distance in pixels from the left end:
+		// new_scroll = pivot_frame - (pivot_frame - pivot_scroll) * pivot_len / len,
+		// calculated in 64 bit fixed point, rounded to the nearest.
+		int64_t const scroll_fx = (int64_t{ pivot_frame } << scroll_frac_bits)
+			- ((int64_t{ pivot_frame - pivot_scroll } * pivot_len) << scroll_frac_bits) / len;
+		int32_t const scroll = std::max(static_cast<int32_t>(
+			(scroll_fx + (int64_t{ 1 } << (scroll_frac_bits - 1))) >> scroll_frac_bits), 0);
+
+		// apply the zoom length under a tweaked state, with the nearest "raw" level.
+		// the left end is the center of zooming, so the scroll position is kept as is.
+		int const m = (level_from_len(len) + (level_one >> 1)) >> level_frac_bits;
+		*exedit.curr_timeline_zoom_level = -1;
+		*exedit.timeline_h_scroll_pos = scroll;
+		auto const t = std::exchange(exedit.timeline_zoom_lengths[m], len);
+		exedit.set_timeline_zoom(m, scroll);
+		exedit.timeline_zoom_lengths[m] = t;
+	}
+	static void set(int32_t level) { set_len(len_from_level(level)); }
+
+	// frame-paced animation toward the target level, for wheel zooming.
+	static constinit struct Animation {
+		// called on each notch of the wheel.
+		void add(int32_t delta_level, int32_t center_frame)
+		{
+			if (!active || last_len != *exedit.curr_timeline_zoom_len || scene != *exedit.current_scene) {
+				// starting a new one, or zoomed by other means in the middle.
+				level = target = get();
+				last_len = *exedit.curr_timeline_zoom_len;
+				scene = *exedit.current_scene;
+			}
+			target = std::clamp(target + delta_level, 0, max_level);
+			pivot(center_frame);
 
-		// calculate the length and the "raw" level, corresponding to the "refined" level.
-		int len2, m;
-		if (level <= 0 || level >= divs * (tl::constants::num_zoom_levels - 1)) {
-			m = level <= 0 ? 0 : tl::constants::num_zoom_levels - 1;
-			len2 = exedit.timeline_zoom_lengths[m];
+			if (!active) {
+				active = true;
+				last_tick = tick();
+				::SetTimer(enhanced_tl::this_fp->hwnd, timer_id(), interval(), on_timer);
+			}
+		}
+		void stop()
+		{
+			if (!active) return;
+			active = false;
+			::KillTimer(enhanced_tl::this_fp->hwnd, timer_id());
 		}
-		else {
-			m = level / divs; int f = level % divs;
-			int dlen = exedit.timeline_zoom_lengths[m + 1] - exedit.timeline_zoom_lengths[m];
-			len2 = exedit.timeline_zoom_lengths[m] + (dlen * f) / divs;
-			if (2 * f >= divs) m++; // round to the nearest.
+
+	private:
+		constexpr static double time_const_ms = 40;
+		bool active = false;
+		int32_t target = 0, level = 0, last_len = 0, scene = 0;
+		int last_tick = 0;
+
+		uintptr_t timer_id() const { return reinterpret_cast<uintptr_t>(this); }
+#pragma warning(suppress : 28159) // 32 bit is enough.
+		static int tick() { return ::GetTickCount(); }
+
+		// the refresh interval of the display in milliseconds.
+		static int interval()
+		{
+			static constinit int ms = 0;
+			if (ms <= 0) {
+				auto const dc = ::GetDC(nullptr);
+				int const hz = ::GetDeviceCaps(dc, VREFRESH);
+				::ReleaseDC(nullptr, dc);
+				ms = std::max<int>(1000 / (hz > 1 ? hz : 60), USER_TIMER_MINIMUM); // 0 or 1 means the default rate.
+			}
+			return ms;
 		}
-		if (len == len2) return; // no need to modify.
 
-		// remove cummulative error.
-		*exedit.timeline_h_scroll_pos +=
-			smooth_zoom::center_frame - tl::point_to_frame(smooth_zoom::center_point);
+		void step()
+		{
+			if (scene != *exedit.current_scene || last_len != *exedit.curr_timeline_zoom_len) {
+				// the scene changed or zoomed by other means; quit the animation.
+				stop();
+				return;
+			}
 
-		// apply the zoom level under a tweaked state.
-		*exedit.curr_timeline_zoom_level = -1;
-		auto const t = std::exchange(exedit.timeline_zoom_lengths[m], len2);
-		exedit.set_timeline_zoom(m, center_frame);
-		exedit.timeline_zoom_lengths[m] = t;
-	}
+			// approach the target exponentially by the elapsed time.
+			int const now = tick(), dt = std::max(now - last_tick, 1);
+			last_tick = now;
+			double const rate = 1 - std::exp(-dt / time_const_ms);
+			int32_t const rest = target - level;
+			if (std::abs(rest) <= (level_one >> 6)) level = target;
+			else level += static_cast<int32_t>(std::lround(rest * rate));
+
+			set(level);
+			last_len = *exedit.curr_timeline_zoom_len;
+			if (level == target) stop();
+		}
+		static void CALLBACK on_timer(HWND hwnd, UINT, UINT_PTR id, DWORD)
+		{
+			if (auto that = reinterpret_cast<Animation*>(id);
+				that != nullptr && hwnd == enhanced_tl::this_fp->hwnd)
+				that->step();
+			else ::KillTimer(hwnd, id);
+		}
+	} animation{};
 }
 
 static constexpr LPARAM point_to_wp(int x, int y) {
@@ -142,7 +231,7 @@ static std::pair<int, int> select_num_beats_BPM(modkeys mkeys)
 {
 	int const N = enhanced_tl::mouse_override::settings.timeline.BPM[mkeys];
 	if (N >= 0) return { 1, std::max(N, 1) }; // 1 / N beats.
-	return { (-N) * *exedit.timeline_BPM_num_beats, 1 }; // (-N) measure lines.
+	return { N, 1 }; // (-N) measure lines; the negative numerator lets each tempo segment apply its own meter.
 }
 
 static bool move_frame(int frame)
@@ -177,20 +266,15 @@ static bool add_midpt(int x, int frame, int layer)
 		std::abs(x - tl::point_from_frame(nearby)) < thresh_near) frame = nearby;
 
 	// find the objects to add a mid-point to.
-	std::set<int32_t> targets;
+	enhanced_tl::object_selection targets;
 	if (auto const* const objects = *exedit.ObjectArray_ptr;
 		*exedit.SelectedObjectNum_ptr > 0) {
-		// if objects are multi-selected, they are the targets.
-		targets = get_multi_selected_objects();
-
-		// limit to the objects that don't contain the specified frame.
-		for (auto it = targets.begin(), e = targets.end(); it != e; ) {
-			auto const curr = it++;
-			auto const idx_obj = *curr;
-
+		// if objects are multi-selected, they are the targets,
+		// limited to the objects that contain the specified frame.
+		for (auto idx_obj : get_multi_selected_objects()) {
 			auto& obj = objects[idx_obj];
-			if (!(obj.frame_begin < frame && frame <= obj.frame_end))
-				targets.erase(curr);
+			if (obj.frame_begin < frame && frame <= obj.frame_end)
+				targets.insert(idx_obj);
 		}
 	}
 	else {
@@ -219,6 +303,7 @@ static bool add_midpt(int x, int frame, int layer)
 			exedit.SelectedObjectIndex[(*exedit.SelectedObjectNum_ptr)++] = idx_new;
 	}
 	if (!modified) return false;
+	tl::index::invalidate();
 
 	// update the setting dialog.
 	if (targets.contains(*exedit.SettingDialogObjectIndex))
@@ -274,24 +359,18 @@ static bool delete_midpt(int x, int frame, int layer)
 		return false;
 
 	// determine the all mid-points to remove.
-	std::set<int32_t> selected = get_multi_selected_objects(), targets;
+	enhanced_tl::object_selection selected = get_multi_selected_objects(), targets;
 	if (auto const* const objects = *exedit.ObjectArray_ptr;
 		!selected.empty()) {
-		// if objects are multi-selected, they are the targets.
-		targets = selected;
-
-		// limit to only the objects that begin with the mid-point at the specified frame.
-		for (auto it = targets.begin(), e = targets.end(); it != e; ) {
-			auto const curr = it++;
-			auto const idx_obj = *curr;
-
+		// if objects are multi-selected, they are the targets,
+		// limited to only the objects that begin with the mid-point at the specified frame.
+		for (auto idx_obj : selected) {
 			auto& obj = objects[idx_obj];
 			if (obj.frame_begin == frame_midpt) { // begins at the specified frame.
 				if (int const idx_leader = obj.index_midpt_leader;
 					idx_leader >= 0 && idx_obj != idx_leader) // the beginning frame is a mid-point.
-					continue;
+					targets.insert(idx_obj);
 			}
-			targets.erase(curr);
 		}
 		if (targets.empty()) return false;
 	}
@@ -312,11 +391,225 @@ static bool delete_midpt(int x, int frame, int layer)
 		selected.erase(idx_old);
 	}
 	if (!modified) return false;
+	tl::index::invalidate();
 	set_multi_selected_objects(selected);
 
 	return true;
 }
 
+// target layers of ripple operations: those with multi-selected objects if any,
+// or all the layers otherwise, excluding locked ones in both cases.
+static tl::index::layer_mask ripple_layers()
+{
+	auto const& layer_states = tl::index::current_layer_states();
+	auto layers = layer_states.nonempty & ~layer_states.locked;
+	if (int const n = *exedit.SelectedObjectNum_ptr; n > 0) {
+		tl::index::layer_mask selected{};
+		auto const* const objects = *exedit.ObjectArray_ptr;
+		for (int i = 0; i < n; i++)
+			selected.set(objects[exedit.SelectedObjectIndex[i]].layer_set);
+		layers = layers & selected;
+	}
+	return layers;
+}
+
+#ifndef NDEBUG
+// time spent in ripple operations, to be read from the debugger.
+static constinit struct {
+	int64_t total = 0, last = 0; // in the units of `QueryPerformanceCounter()`.
+	int32_t count = 0, last_objects = 0;
+	void add(int64_t begin, int num_objects)
+	{
+		LARGE_INTEGER end;
+		::QueryPerformanceCounter(&end);
+		last = end.QuadPart - begin;
+		total += last;
+		count++;
+		last_objects = num_objects;
+	}
+} ripple_counter{};
+#endif
+
+// moves the objects on `layers` that begin at `pos` or later by `delta` frames, all at once.
+// chains of mid-points move as a whole, judged by their first object.
+// if `delta` is negative and some objects would overlap others, nothing moves.
+// if `delta` is positive, it is reduced so no object goes beyond the end of the scene.
+static bool ripple_shift(int32_t pos, int32_t delta, tl::index::layer_mask layers)
+{
+	if (delta == 0) return false;
+#ifndef NDEBUG
+	LARGE_INTEGER time_begin;
+	::QueryPerformanceCounter(&time_begin);
+#endif
+
+	// determine the range of objects to move on each layer.
+	struct range { int first, last; }; // in `exedit.SortedObject`.
+	std::vector<range> ranges{};
+	for (int layer : layers) {
+		int const
+			L = exedit.SortedObjectLayerBeginIndex[layer],
+			R = exedit.SortedObjectLayerEndIndex[layer];
+		if (L > R) continue;
+
+		int j = static_cast<int>(std::partition_point(exedit.SortedObject + L, exedit.SortedObject + R + 1,
+			[pos](auto const* obj) { return obj->frame_begin < pos; }) - exedit.SortedObject);
+		// skip the rest of the chain that began on the left.
+		while (j <= R && j > L) {
+			int const leader = exedit.SortedObject[j]->index_midpt_leader;
+			if (leader < 0 || leader != exedit.SortedObject[j - 1]->index_midpt_leader) break;
+			j++;
+		}
+		if (j > R) continue;
+
+		if (delta < 0 && (exedit.SortedObject[j]->frame_begin + delta < 0 ||
+			(j > L && exedit.SortedObject[j - 1]->frame_end >= exedit.SortedObject[j]->frame_begin + delta)))
+			return false; // would overlap, or go beyond the beginning.
+		ranges.push_back({ j, R });
+	}
+	if (ranges.empty()) return false;
+
+	if (delta > 0) {
+		int32_t last_end = 0;
+		for (auto [_, last] : ranges)
+			last_end = std::max(last_end, exedit.SortedObject[last]->frame_end);
+		delta = std::min(delta, *exedit.curr_scene_len - 1 - last_end);
+		if (delta <= 0) return false; // no room left.
+	}
+
+	// move the objects in a single pass.
+	int const dlg_obj_idx = *exedit.SettingDialogObjectIndex;
+	bool should_update_dialog = false;
+	int num_moved = 0;
+	exedit.nextundo();
+	auto const* const head_ptr = *exedit.ObjectArray_ptr;
+	for (auto [first, last] : ranges) {
+		for (int j = first; j <= last; j++) {
+			auto* const obj = exedit.SortedObject[j];
+			int const index = obj - head_ptr;
+
+			exedit.setundo(index, 0x08);
+			obj->frame_begin += delta;
+			obj->frame_end += delta;
+
+			if (index == dlg_obj_idx) should_update_dialog = true;
+		}
+		num_moved += last - first + 1;
+	}
+	exedit.update_object_tables();
+	tl::index::invalidate();
+
+#ifndef NDEBUG
+	ripple_counter.add(time_begin.QuadPart, num_moved);
+#endif
+
+	// redraw the timeline.
+	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
+
+	// update the dialog if the moved object is selected.
+	if (should_update_dialog) {
+		ForceKeyState k{ VK_CONTROL, true }; // otherwise objects are deselected.
+		update_setting_dialog(dlg_obj_idx);
+	}
+	return true;
+}
+
+// rectangle selection by drags::Bk_Ctrl_L.
+// each move binary-searches the frame range on each layer in the rectangle,
+// and touches only the objects entering or leaving it since the last move.
+#ifdef NDEBUG
+constinit
+#endif
+static struct RubberBand {
+	enhanced_tl::object_selection base{}, curr{};
+
+	void begin(int x, int y)
+	{
+		frame_start = tl::point_to_frame(x);
+		layer_start = tl::point_to_layer(y);
+		layer_top = 0; layer_bottom = -1;
+		base = curr = get_multi_selected_objects();
+		rect_drawn = false;
+	}
+
+	// returns `true` if the selection has changed.
+	bool update(int x, int y)
+	{
+		int32_t const frame = tl::point_to_frame(x),
+			f0 = std::min(frame_start, frame), f1 = std::max(frame_start, frame);
+		int const layer = std::clamp(tl::point_to_layer(y), 0, tl::constants::num_layers - 1),
+			l0 = std::min(layer_start, layer), l1 = std::max(layer_start, layer);
+		auto const locked = tl::index::current_layer_states().locked;
+
+		bool modified = false;
+		auto const* const head_ptr = *exedit.ObjectArray_ptr;
+		for (int l = std::min(layer_top, l0), e = std::max(layer_bottom, l1); l <= e; l++) {
+			range const prev = layer_top <= l && l <= layer_bottom ? ranges[l] : range{},
+				next = l0 <= l && l <= l1 && !locked.test(l) ? objects_in(l, f0, f1) : range{};
+
+			// objects leaving the rectangle, unless they were selected from the beginning.
+			for (auto [a, b] : { range{ prev.first, std::min(prev.last, next.first) },
+				range{ std::max(prev.first, next.last), prev.last } }) {
+				for (int j = a; j < b; j++) {
+					if (int const idx = exedit.SortedObject[j] - head_ptr; !base.contains(idx))
+						modified |= curr.erase(idx);
+				}
+			}
+			// objects entering the rectangle.
+			for (auto [a, b] : { range{ next.first, std::min(next.last, prev.first) },
+				range{ std::max(next.first, prev.last), next.last } }) {
+				for (int j = a; j < b; j++)
+					modified |= curr.insert(exedit.SortedObject[j] - head_ptr);
+			}
+			ranges[l] = next;
+		}
+		layer_top = l0; layer_bottom = l1;
+		return modified;
+	}
+
+	// draws or erases the rectangle in XOR mode.
+	void toggle_rect(int x, int y)
+	{
+		if (!rect_drawn) rect = {
+			std::min<int>(pt_origin().x, x), std::min<int>(pt_origin().y, y),
+			std::max<int>(pt_origin().x, x) + 1, std::max<int>(pt_origin().y, y) + 1,
+		};
+		HDC const dc = ::GetDC(exedit.fp->hwnd);
+		::DrawFocusRect(dc, &rect);
+		::ReleaseDC(exedit.fp->hwnd, dc);
+		rect_drawn = !rect_drawn;
+	}
+	void erase_rect() { if (rect_drawn) toggle_rect(0, 0); }
+	void forget_rect() { rect_drawn = false; }
+
+private:
+	struct range { int first = 0, last = 0; }; // [first, last) in `exedit.SortedObject`.
+	range ranges[tl::constants::num_layers]{};
+	int layer_top = 0, layer_bottom = -1, layer_start = 0;
+	int32_t frame_start = 0;
+	RECT rect{};
+	bool rect_drawn = false;
+
+	POINT pt_origin() const
+	{
+		return { tl::point_from_frame(frame_start), tl::point_from_layer(layer_start) };
+	}
+
+	// the objects on the layer that intersect [f0, f1].
+	static range objects_in(int layer, int32_t f0, int32_t f1)
+	{
+		int const
+			L = exedit.SortedObjectLayerBeginIndex[layer],
+			R = exedit.SortedObjectLayerEndIndex[layer];
+		if (L > R) return {};
+
+		// objects in a layer don't overlap, so both ends are sorted.
+		auto* const first = exedit.SortedObject + L, * const last = exedit.SortedObject + R + 1;
+		auto* const a = std::partition_point(first, last, [f0](auto const* obj) { return obj->frame_end < f0; });
+		auto* const b = std::partition_point(a, last, [f1](auto const* obj) { return obj->frame_begin <= f1; });
+		return { static_cast<int>(a - exedit.SortedObject), static_cast<int>(b - exedit.SortedObject) };
+	}
+} rubber_band{};
+
 // buffering the selection origin.
 static int32_t back_selection_origin = 0;
 
@@ -636,6 +929,10 @@ bool expt::drags::Bk_Ctrl_L::on_mouse_down_core(modkeys mkeys)
 {
 	prev_scene = *exedit.current_scene;
 
+	// take the selection before exedit handles the click below.
+	// objects in the rectangle are added to this selection.
+	rubber_band.begin(pt_start.x, pt_start.y);
+
 	// check if the cursor is on an object.
 	if (exedit.obj_from_point(pt_start.x, pt_start.y) < 0) {
 		ForceKeyState k{
@@ -643,52 +940,57 @@ bool expt::drags::Bk_Ctrl_L::on_mouse_down_core(modkeys mkeys)
 			VK_SHIFT, false,
 			VK_MENU, false,
 		};
-		return FALSE != internal::call_next_proc(WM_LBUTTONDOWN,
+		internal::call_next_proc(WM_LBUTTONDOWN,
 			keys_to_wp(mouse_button::L, modkeys::ctrl),
 			point_to_wp(pt_start.x, pt_start.y));
 	}
-
-	// if the cursor is on an object, initiate Alt+drag and change the mode.
-	// initiating Alt+drag is in order to update the click position for pasting,
-	// which involves modified code by patch.aul.
-	{
+	else {
+		// if the cursor is on an object, initiate Alt+drag.
+		// initiating Alt+drag is in order to update the click position for pasting,
+		// which involves modified code by patch.aul.
 		ForceKeyState k{ VK_MENU, true };
 		internal::call_next_proc(WM_LBUTTONDOWN,
 			MK_LBUTTON,
 			point_to_wp(pt_start.x, pt_start.y));
 	}
 
-	// then turn to range-selection drag.
-	exedit.begin_range_selection(pt_start.x, pt_start.y);
-	*exedit.timeline_drag_kind = drag_kind::range_select;
+	// then quit the drag of exedit and select objects natively,
+	// instead of `exedit.begin_range_selection()` which scans all the objects on every move.
+	*exedit.timeline_drag_kind = drag_kind::none;
+	set_multi_selected_objects(rubber_band.base);
+	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
+	::SetCapture(exedit.fp->hwnd);
 	return false;
 }
 bool expt::drags::Bk_Ctrl_L::on_mouse_move_core(modkeys mkeys)
 {
-	ForceKeyState k{
-		VK_CONTROL, true,
-		VK_SHIFT, false,
-		VK_MENU, false,
-	};
-	return FALSE != internal::call_next_proc(WM_MOUSEMOVE,
-		keys_to_wp(mouse_button::L, modkeys::ctrl),
-		point_to_wp(pt_curr.x, pt_curr.y));
+	if (rubber_band.update(pt_curr.x, pt_curr.y)) {
+		set_multi_selected_objects(rubber_band.curr);
+
+		// redraw the entire timeline, which also erases the rectangle.
+		::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
+		::UpdateWindow(exedit.fp->hwnd);
+		rubber_band.forget_rect();
+	}
+	else rubber_band.erase_rect();
+	rubber_band.toggle_rect(pt_curr.x, pt_curr.y);
+	return false;
 }
 bool expt::drags::Bk_Ctrl_L::on_mouse_up_core(modkeys mkeys)
 {
-	ForceKeyState k{
-		VK_CONTROL, true,
-		VK_SHIFT, false,
-		VK_MENU, false,
-	};
-	return FALSE != internal::call_next_proc(WM_LBUTTONUP,
-		keys_to_wp(modkeys::ctrl),
-		point_to_wp(pt_curr.x, pt_curr.y));
+	rubber_band.erase_rect();
+	::ReleaseCapture();
+	return false;
 }
 bool expt::drags::Bk_Ctrl_L::on_mouse_cancel_core(bool release)
 {
-	// releasing Ctrl aborts dragging and deselects objects.
-	internal::call_next_proc(WM_KEYUP, VK_CONTROL, 0);
+	// restore the selection before the drag.
+	rubber_band.erase_rect();
+	if (prev_scene == *exedit.current_scene) {
+		set_multi_selected_objects(rubber_band.base);
+		::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
+	}
+	if (release) ::ReleaseCapture();
 	return false;
 }
 bool expt::drags::Bk_Ctrl_L::handle_key_messages_core(bool& ret, UINT message, WPARAM wparam, LPARAM lparam)
@@ -742,7 +1044,8 @@ bool expt::drags::Alt_L::on_mouse_cancel_core(bool release)
 bool expt::drags::Zoom_Bi::can_continue() const { return !active() || prev_scene == *exedit.current_scene; }
 bool expt::drags::Zoom_Bi::on_mouse_down_core(modkeys mkeys)
 {
-	prev_zoom_h = smooth_zoom::get(settings.timeline.zoom_drag_refine_x);
+	smooth_zoom::animation.stop();
+	prev_zoom_h = *exedit.curr_timeline_zoom_len;
 	prev_frame = *exedit.timeline_h_scroll_pos;
 	prev_zoom_v = lr::get_layer_size_delayed();
 	smooth_zoom::pivot(internal::zoom_center_frame(settings.timeline.zoom_center_drag, pt_start.x));
@@ -755,15 +1058,18 @@ bool expt::drags::Zoom_Bi::on_mouse_down_core(modkeys mkeys)
 bool expt::drags::Zoom_Bi::on_mouse_move_core(modkeys mkeys)
 {
 	// calculate the delta values of each scalings.
-	int const delta_h = settings.timeline.zoom_drag_length_x == 0 ? 0 :
-		((pt_curr.x - pt_start.x) * settings.timeline.zoom_drag_refine_x)
-		/ settings.timeline.zoom_drag_length_x;
+	// horizontal one is continuous unless `zoom_drag_refine_x` specifies the steps per level.
+	int32_t delta_h = settings.timeline.zoom_drag_length_x == 0 ? 0 :
+		static_cast<int32_t>((int64_t{ pt_curr.x - pt_start.x } << smooth_zoom::level_frac_bits)
+		/ settings.timeline.zoom_drag_length_x);
+	if (int const divs = settings.timeline.zoom_drag_refine_x; divs > 0)
+		delta_h = static_cast<int32_t>(int64_t{ delta_h } * divs / smooth_zoom::level_one * smooth_zoom::level_one / divs);
 	int const delta_v = settings.timeline.zoom_drag_length_y == 0 ? 0 :
 		(pt_curr.y - pt_start.y) / settings.timeline.zoom_drag_length_y;
 
 	// apply zooming; layer-wise comes first.
 	lr::set_layer_size(prev_zoom_v + delta_v, true);
-	smooth_zoom::set(prev_zoom_h + delta_h, settings.timeline.zoom_drag_refine_x);
+	smooth_zoom::set(smooth_zoom::level_from_len(prev_zoom_h) + delta_h);
 	return false;
 }
 bool expt::drags::Zoom_Bi::on_mouse_up_core(modkeys mkeys)
@@ -778,7 +1084,7 @@ bool expt::drags::Zoom_Bi::on_mouse_cancel_core(bool release)
 	// rewind the states.
 	if (prev_scene == *exedit.current_scene) {
 		lr::set_layer_size(prev_zoom_v, false);
-		smooth_zoom::set(prev_zoom_h, settings.timeline.zoom_drag_refine_x);
+		smooth_zoom::set_len(prev_zoom_h);
 		wa::set_frame_scroll(prev_frame, *exedit.editp);
 	}
 	return false;
@@ -859,7 +1165,7 @@ bool expt::drags::Step_BPM::on_mouse_move_core(modkeys mkeys)
 
 	// find the nearby grid line.
 	auto const [beat_numer, beat_denom] = select_num_beats_BPM(mkeys);
-	bpm::BPM_Grid const grid{ beat_numer, beat_denom };
+	auto const& grid = bpm::current_grid(beat_numer, beat_denom);
 	auto const beat = grid.beat_from_pos(frame);
 	int const
 		l = grid.pos_from_beat(beat),
@@ -893,6 +1199,55 @@ bool expt::drags::Step_BPM::on_mouse_cancel_core(bool release)
 	return move_frame(prev_frame);
 }
 
+// drags::Step_Marker
+bool expt::drags::Step_Marker::on_mouse_down_core(modkeys mkeys)
+{
+	// save the state to rewind later.
+	prev_frame = *exedit.curr_edit_frame;
+	::SetCapture(target);
+	::SetCursor(::LoadCursorW(nullptr, reinterpret_cast<wchar_t const*>(IDC_UPARROW)));
+	return on_mouse_move_core(mkeys);
+}
+bool expt::drags::Step_Marker::on_mouse_move_core(modkeys mkeys)
+{
+	namespace mk = enhanced_tl::markers;
+	constexpr int thresh_near = 16;
+
+	// get the current frame.
+	int const frame = tl::point_to_frame(pt_curr.x);
+
+	// find the nearby markers.
+	auto const l = mk::find_left(frame + 1), r = mk::find_right(frame);
+	if (!l && !r) return false;
+	int const
+		l_x = l ? tl::point_from_frame(*l) : std::numeric_limits<int>::min() / 2,
+		r_x = r ? tl::point_from_frame(*r) : std::numeric_limits<int>::max() / 2;
+
+	// choose the closer one.
+	int dest, dist;
+	if (pt_curr.x - l_x <= r_x - pt_curr.x) {
+		dest = *l; dist = pt_curr.x - l_x;
+	}
+	else {
+		dest = *r; dist = r_x - pt_curr.x;
+	}
+
+	return dist <= thresh_near && dest < *exedit.curr_scene_len
+		&& dest != *exedit.curr_edit_frame && move_frame(dest);
+}
+bool expt::drags::Step_Marker::on_mouse_up_core(modkeys mkeys)
+{
+	::ReleaseCapture();
+	return false; // no need to refresh the current frame.
+}
+bool expt::drags::Step_Marker::on_mouse_cancel_core(bool release)
+{
+	if (release) ::ReleaseCapture();
+
+	// rewind the current frame.
+	return move_frame(prev_frame);
+}
+
 ////////////////////////////////
 // クリック．
 ////////////////////////////////
@@ -986,16 +1341,15 @@ bool expt::clicks::select_line_left(int x, int y, modkeys mkeys)
 	if (j < 0) return false; // no objects on the left.
 
 	// manipulate as sets.
-	std::set<int> selected = get_multi_selected_objects(), targets{};
+	enhanced_tl::object_selection selected = get_multi_selected_objects(), targets{};
 
-	bool contained = true;
 	auto const* const head_ptr = *exedit.ObjectArray_ptr;
 	for (; j >= L; j--) {
-		int const idx = exedit.SortedObject[j] - head_ptr;
-		targets.insert(idx);
-		if (selected.erase(idx) == 0) contained = false;
+		targets.insert(exedit.SortedObject[j] - head_ptr);
 	}
-	if (!contained) selected.insert_range(targets);
+	// deselect if all are selected, otherwise select all.
+	if (selected.includes(targets)) selected -= targets;
+	else selected |= targets;
 
 	// write to the memory.
 	set_multi_selected_objects(selected);
@@ -1028,16 +1382,15 @@ bool expt::clicks::select_line_right(int x, int y, modkeys mkeys)
 		return false; // no objects on the right.
 
 	// manipulate as sets.
-	std::set<int> selected = get_multi_selected_objects(), targets{};
+	enhanced_tl::object_selection selected = get_multi_selected_objects(), targets{};
 
-	bool contained = true;
 	auto const* const head_ptr = *exedit.ObjectArray_ptr;
 	for (; j <= R; j++) {
-		int const idx = exedit.SortedObject[j] - head_ptr;
-		targets.insert(idx);
-		if (selected.erase(idx) == 0) contained = false;
+		targets.insert(exedit.SortedObject[j] - head_ptr);
 	}
-	if (!contained) selected.insert_range(targets);
+	// deselect if all are selected, otherwise select all.
+	if (selected.includes(targets)) selected -= targets;
+	else selected |= targets;
 
 	// write to the memory.
 	set_multi_selected_objects(selected);
@@ -1055,11 +1408,8 @@ bool expt::clicks::select_all(int x, int y, modkeys mkeys)
 
 	auto const* const head_ptr = *exedit.ObjectArray_ptr;
 	int const prev_count = std::exchange(*exedit.SelectedObjectNum_ptr, 0);
-	auto const* layer_settings = &exedit.LayerSettings[tl::constants::num_layers * *exedit.current_scene];
-	for (int l = 0; l < tl::constants::num_layers; l++) {
-		// skip locked layers.
-		if (has_flag_or(layer_settings[l].flag, ExEdit::LayerSetting::Flag::Locked)) continue;
-
+	auto const& layer_states = tl::index::current_layer_states();
+	for (int l : layer_states.nonempty & ~layer_states.locked) { // skip locked layers.
 		for (int j = exedit.SortedObjectLayerBeginIndex[l], R = exedit.SortedObjectLayerEndIndex[l];
 			j <= R; j++) {
 			exedit.SelectedObjectIndex[(*exedit.SelectedObjectNum_ptr)++]
@@ -1126,6 +1476,7 @@ bool expt::clicks::squeeze_left(int x, int y, modkeys mkeys)
 
 		if (index == dlg_obj_idx) should_update_dialog = true;
 	}
+	tl::index::invalidate();
 
 	// redraw the timeline.
 	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
@@ -1187,6 +1538,7 @@ bool expt::clicks::squeeze_right(int x, int y, modkeys mkeys)
 
 		if (index == dlg_obj_idx) should_update_dialog = true;
 	}
+	tl::index::invalidate();
 
 	// redraw the timeline.
 	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
@@ -1199,6 +1551,50 @@ bool expt::clicks::squeeze_right(int x, int y, modkeys mkeys)
 	return true;
 }
 
+// clicks::ripple_delete
+bool expt::clicks::ripple_delete(int x, int y, modkeys mkeys)
+{
+	if (!is_editing()) return false;
+
+	// removes the blank space at the clicked point that is common to
+	// all the target layers, moving the objects on the right to the left.
+	int const frame = tl::point_to_frame(x);
+	auto const layers = ripple_layers();
+	if (layers.empty()) return false;
+
+	// intersect the gaps at the clicked point.
+	int32_t l = 0, r = std::numeric_limits<int32_t>::max();
+	for (int layer : layers) {
+		int const
+			i = tl::find_left_sorted_index(frame, layer),
+			R = exedit.SortedObjectLayerEndIndex[layer];
+		if (i >= 0) {
+			if (exedit.SortedObject[i]->frame_end >= frame)
+				return false; // an object occupies the point.
+			l = std::max(l, exedit.SortedObject[i]->frame_end + 1);
+		}
+		if (int const j = i < 0 ? exedit.SortedObjectLayerBeginIndex[layer] : i + 1; j <= R)
+			r = std::min(r, exedit.SortedObject[j]->frame_begin);
+	}
+	if (r == std::numeric_limits<int32_t>::max()) return false; // nothing on the right.
+
+	return ripple_shift(r, l - r, layers);
+}
+
+// clicks::ripple_insert
+bool expt::clicks::ripple_insert(int x, int y, modkeys mkeys)
+{
+	if (!is_editing()) return false;
+
+	// inserts a blank space between the current frame and the clicked point
+	// to all the target layers, moving the objects on the right further.
+	int const
+		frame = tl::point_to_frame(x),
+		curr = *exedit.curr_edit_frame;
+
+	return ripple_shift(std::min(frame, curr), std::abs(frame - curr), ripple_layers());
+}
+
 // clicks::toggle_active
 bool expt::clicks::toggle_active(int x, int y, modkeys mkeys)
 {
@@ -1210,9 +1606,9 @@ bool expt::clicks::toggle_active(int x, int y, modkeys mkeys)
 
 	// determine the objects to toggle.
 	auto* const objects = *exedit.ObjectArray_ptr;
-	std::set<int32_t> targets{};
+	enhanced_tl::object_selection targets{};
 	{
-		std::set<int32_t> selected = get_multi_selected_objects();
+		enhanced_tl::object_selection selected = get_multi_selected_objects();
 		selected.insert(idx_obj);
 
 		// collect the leading objects.
@@ -1250,6 +1646,7 @@ bool expt::clicks::toggle_active(int x, int y, modkeys mkeys)
 			status ^= flag_active;
 		}
 	}
+	tl::index::invalidate();
 
 	// redraw the timeline.
 	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
@@ -1296,6 +1693,16 @@ bool expt::wheels::scroll_v(int screen_x, int screen_y, int delta, modkeys mkeys
 // wheels::zoom_h
 bool expt::wheels::zoom_h(int screen_x, int screen_y, int delta, modkeys mkeys)
 {
+	if (settings.timeline.zoom_wheel_smooth) {
+		if (!is_editing()) return false;
+
+		// animate continuously, by a level per notch.
+		smooth_zoom::animation.add(
+			static_cast<int32_t>((int64_t{ delta } << smooth_zoom::level_frac_bits) / WHEEL_DELTA),
+			internal::zoom_center_frame(settings.timeline.zoom_center_wheel, screen_x, screen_y));
+		return false;
+	}
+
 	ForceKeyState k{
 		VK_CONTROL, true,
 		VK_SHIFT, false,
@@ -1370,7 +1777,7 @@ bool expt::wheels::step_bpm_grid(int screen_x, int screen_y, int delta, modkeys
 
 	// find the nearby grid line.
 	auto const [beat_numer, beat_denom] = select_num_beats_BPM(mkeys);
-	bpm::BPM_Grid const grid{ beat_numer, beat_denom };
+	auto const& grid = bpm::current_grid(beat_numer, beat_denom);
 	int const dest = delta > 0 ?
 		grid.pos_from_beat(grid.beat_from_pos(frame - 1)) : // to left.
 		grid.pos_from_beat(grid.beat_from_pos(frame) + 1); // to right.
@@ -1378,6 +1785,14 @@ bool expt::wheels::step_bpm_grid(int screen_x, int screen_y, int delta, modkeys
 	return dest != frame && move_frame(dest);
 }
 
+// wheels::step_marker
+bool expt::wheels::step_marker(int screen_x, int screen_y, int delta, modkeys mkeys)
+{
+	if (!is_editing()) return false;
+	return wa::on_menu_command(enhanced_tl::this_fp->hwnd,
+		delta > 0 ? wa::menu::step_marker_left : wa::menu::step_marker_right, *exedit.editp);
+}
+
 // wheels::change_scene
 bool expt::wheels::change_scene(int screen_x, int screen_y, int delta, modkeys mkeys)
 {
@@ -132,6 +132,16 @@ namespace enhanced_tl::mouse_override::timeline
 			bool on_mouse_cancel_core(bool release) override;
 			bool handle_key_messages_core(bool& ret, UINT message, WPARAM wparam, LPARAM lparam) override { return true; }
 		} step_bpm;
+
+		/// @brief snaps the current frame to markers.
+		inline struct Step_Marker : drag_state {
+		protected:
+			bool on_mouse_down_core(modkeys mkeys) override;
+			bool on_mouse_move_core(modkeys mkeys) override;
+			bool on_mouse_up_core(modkeys mkeys) override;
+			bool on_mouse_cancel_core(bool release) override;
+			bool handle_key_messages_core(bool& ret, UINT message, WPARAM wparam, LPARAM lparam) override { return true; }
+		} step_marker;
 	}
 
 	namespace clicks
@@ -146,6 +156,8 @@ namespace enhanced_tl::mouse_override::timeline
 			select_all,
 			squeeze_left,
 			squeeze_right,
+			ripple_delete,
+			ripple_insert,
 			toggle_active;
 	}
 
@@ -163,6 +175,7 @@ namespace enhanced_tl::mouse_override::timeline
 			step_midpt_scene,
 			step_obj_scene,
 			step_bpm_grid,
+			step_marker,
 			change_scene;
 	}
 }
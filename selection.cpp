@@ -0,0 +1,128 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <vector>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+using byte = uint8_t;
+#include <exedit.hpp>
+
+#include "enhanced_tl.hpp"
+#include "selection.hpp"
+
+
+////////////////////////////////
+// Exported functions.
+////////////////////////////////
+using object_selection = enhanced_tl::object_selection;
+
+object_selection& object_selection::operator|=(object_selection const& other)
+{
+	if (words.size() < other.words.size()) words.resize(other.words.size(), 0);
+	size_t c = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		if (i < other.words.size()) words[i] |= other.words[i];
+		c += std::popcount(words[i]);
+	}
+	count = c; invalidate();
+	return *this;
+}
+
+object_selection& object_selection::operator-=(object_selection const& other)
+{
+	size_t c = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		if (i < other.words.size()) words[i] &= ~other.words[i];
+		c += std::popcount(words[i]);
+	}
+	count = c; invalidate();
+	return *this;
+}
+
+object_selection& object_selection::operator^=(object_selection const& other)
+{
+	if (words.size() < other.words.size()) words.resize(other.words.size(), 0);
+	size_t c = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		if (i < other.words.size()) words[i] ^= other.words[i];
+		c += std::popcount(words[i]);
+	}
+	count = c; invalidate();
+	return *this;
+}
+
+bool object_selection::includes(object_selection const& other) const
+{
+	if (other.count > count) return false;
+	for (size_t i = 0; i < other.words.size(); i++) {
+		word const w = i < words.size() ? words[i] : 0;
+		if ((other.words[i] & ~w) != 0) return false;
+	}
+	return true;
+}
+
+std::span<int32_t const> object_selection::indices() const
+{
+	if (!sorted_valid) {
+		// collect the set bits in ascending order.
+		sorted.resize(count);
+		auto* p = sorted.data();
+		for (size_t i = 0; i < words.size(); i++) {
+			for (word w = words[i]; w != 0; w &= w - 1)
+				*p++ = static_cast<int32_t>(i * word_bits + std::countr_zero(w));
+		}
+		sorted_valid = true;
+	}
+	return sorted;
+}
+
+// 複数選択オブジェクトの読み込み．
+object_selection object_selection::current()
+{
+	std::span<int32_t const> const src{ exedit.SelectedObjectIndex,
+		static_cast<size_t>(std::max(*exedit.SelectedObjectNum_ptr, 0)) };
+
+	object_selection ret{};
+	if (src.empty()) return ret;
+	ret.reserve_index(*std::ranges::max_element(src));
+	for (auto idx : src) {
+		word& w = ret.words[idx / word_bits];
+		word const bit = word{ 1 } << (idx % word_bits);
+		ret.count += (w & bit) == 0;
+		w |= bit;
+	}
+
+	// the array is often in ascending order already, then it serves as is.
+	if (std::ranges::is_sorted(src) && ret.count == src.size())
+		ret.sorted.assign(src.begin(), src.end());
+	else ret.sorted_valid = false;
+	return ret;
+}
+
+// 複数選択オブジェクトの書き戻し．
+void object_selection::write_back() const
+{
+	// a single pass over the bits; the cached array is not needed.
+	auto* p = exedit.SelectedObjectIndex;
+	for (size_t i = 0; i < words.size(); i++) {
+		for (word w = words[i]; w != 0; w &= w - 1)
+			*p++ = static_cast<int32_t>(i * word_bits + std::countr_zero(w));
+	}
+	*exedit.SelectedObjectNum_ptr = static_cast<int32_t>(count);
+}
@@ -0,0 +1,95 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <initializer_list>
+#include <vector>
+#include <span>
+
+
+////////////////////////////////
+// オブジェクトの複数選択．
+////////////////////////////////
+namespace enhanced_tl
+{
+	/// @brief オブジェクト配列のインデックスの集合．
+	/// ビット列で所属を判定し，走査用に昇順の配列を必要になった時点で作り直す．
+	class object_selection {
+		using word = uint64_t;
+		constexpr static int32_t word_bits = std::numeric_limits<word>::digits;
+
+		std::vector<word> words{};
+		size_t count = 0;
+		mutable std::vector<int32_t> sorted{};
+		mutable bool sorted_valid = true;
+
+		void reserve_index(int32_t idx) {
+			if (size_t const n = idx / word_bits + 1; words.size() < n) words.resize(n, 0);
+		}
+		void invalidate() { sorted_valid = false; }
+
+	public:
+		object_selection() = default;
+		object_selection(std::initializer_list<int32_t> indices) {
+			for (auto idx : indices) insert(idx);
+		}
+
+		bool contains(int32_t idx) const {
+			size_t const w = idx / word_bits;
+			return idx >= 0 && w < words.size()
+				&& ((words[w] >> (idx % word_bits)) & 1) != 0;
+		}
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		/// @return 新たに追加した場合は `true`.
+		bool insert(int32_t idx) {
+			if (idx < 0) return false;
+			reserve_index(idx);
+			word& w = words[idx / word_bits];
+			word const bit = word{ 1 } << (idx % word_bits);
+			if ((w & bit) != 0) return false;
+			w |= bit;
+			count++; invalidate();
+			return true;
+		}
+		/// @return 含まれていたものを削除した場合は `true`.
+		bool erase(int32_t idx) {
+			if (!contains(idx)) return false;
+			words[idx / word_bits] &= ~(word{ 1 } << (idx % word_bits));
+			count--; invalidate();
+			return true;
+		}
+		void clear() { words.clear(); count = 0; sorted.clear(); sorted_valid = true; }
+
+		// ワード単位の集合演算．
+		object_selection& operator|=(object_selection const& other);
+		object_selection& operator-=(object_selection const& other);
+		object_selection& operator^=(object_selection const& other);
+		/// @return `other` のすべての要素を含む場合は `true`.
+		bool includes(object_selection const& other) const;
+
+		/// @brief 昇順に並べたインデックス．
+		/// 集合を変更すると，以前に返した範囲は無効になる．
+		std::span<int32_t const> indices() const;
+		auto begin() const { return indices().begin(); }
+		auto end() const { return indices().end(); }
+
+		/// @brief 現在の複数選択オブジェクトを読み込む．
+		static object_selection current();
+		/// @brief 複数選択オブジェクトとして昇順に書き戻す．
+		void write_back() const;
+	};
+}
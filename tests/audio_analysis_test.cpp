@@ -0,0 +1,134 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// クリック音の列に対して `estimate_tempo()` がテンポと拍の位置を正しく推定することと，
+// 粗い段を使った `find_transient()` が細かい段だけの検索と同じ結果になることの確認．
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <numbers>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "../audio_analysis.hpp"
+
+namespace aa = enhanced_tl::audio_analysis;
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; std::printf(__VA_ARGS__); std::printf("\n"); } } while (false)
+
+// a metronome-like click track: short decaying noise bursts on every beat.
+static std::vector<float> click_track(uint32_t sample_rate, double bpm, double first_beat, double seconds)
+{
+	std::vector<float> ret(static_cast<size_t>(sample_rate * seconds), 0.0f);
+	std::mt19937 rng{ 6789 };
+	std::uniform_real_distribution<float> noise{ -1.0f, 1.0f };
+	size_t const click_len = sample_rate / 100; // 10 ms.
+	for (double t = first_beat; t < seconds; t += 60 / bpm) {
+		size_t const at = static_cast<size_t>(std::lround(t * sample_rate));
+		for (size_t i = 0; i < click_len && at + i < ret.size(); i++)
+			ret[at + i] = 0.5f * noise(rng) * std::exp(-5.0f * i / click_len);
+	}
+	return ret;
+}
+
+static void check_track(uint32_t sample_rate, double bpm, double first_beat)
+{
+	auto const samples = click_track(sample_rate, bpm, first_beat, 30);
+
+	// feed in uneven chunks as the plugin reads them from a file.
+	aa::onset_envelope env{ sample_rate };
+	for (size_t i = 0; i < samples.size(); i += 4000)
+		env.feed(std::span{ samples }.subspan(i, std::min<size_t>(4000, samples.size() - i)));
+	auto const est = aa::estimate_tempo(env.finish(), env.hop_seconds(), env.time_offset());
+	CHECK(est.has_value(), "%.1f BPM at %u Hz: no estimate", bpm, sample_rate);
+	if (!est) return;
+
+	// the tempo within 0.2%, and a beat within 10 ms from a click.
+	CHECK(std::abs(est->bpm / bpm - 1) < 0.002,
+		"%.1f BPM at %u Hz: estimated %.3f BPM", bpm, sample_rate, est->bpm);
+	double const period = 60 / bpm,
+		diff = std::remainder(est->first_beat - first_beat, period);
+	CHECK(std::abs(diff) < 0.010,
+		"%.1f BPM at %u Hz: first beat %.4f s, off by %.4f s from the clicks", bpm, sample_rate, est->first_beat, diff);
+}
+
+// bursts of noise between silences, so the coarse levels have quiet spans to skip.
+static std::vector<float> bursts(size_t num_samples)
+{
+	std::vector<float> ret(num_samples, 0.0f);
+	std::mt19937 rng{ 4321 };
+	std::uniform_real_distribution<float> noise{ -1.0f, 1.0f }, gain{ 0.05f, 0.9f };
+	std::uniform_int_distribution<size_t> gap{ 0, 40'000 }, len{ 1, 3'000 };
+	for (size_t at = gap(rng); at < num_samples; at += gap(rng)) {
+		float const g = gain(rng);
+		for (size_t n = len(rng); n > 0 && at < num_samples; n--, at++) ret[at] = g * noise(rng);
+	}
+	return ret;
+}
+
+static void check_transients()
+{
+	// bucket lengths like the zoom levels: decreasing, not multiples of each other.
+	double const lens[] = { 7351.7, 2940.3, 1470.1, 612.5, 245.0, 98.0, 36.75 };
+	constexpr size_t num_levels = std::size(lens);
+	auto const samples = bursts(1'500'000);
+
+	std::vector<aa::peak> storage[num_levels];
+	std::span<aa::peak> outputs[num_levels];
+	for (size_t z = 0; z < num_levels; z++) {
+		storage[z].resize(aa::peak_pyramid_builder::level_size(lens[z], samples.size()));
+		outputs[z] = storage[z];
+	}
+	aa::peak_pyramid_builder builder{ lens, outputs };
+	builder.feed(samples);
+	builder.finish();
+
+	std::mt19937 rng{ 98765 };
+	int const thresholds[] = { 1, 3000, 10000, 25000 };
+	for (size_t z = 0; z < num_levels; z++) {
+		std::vector<aa::coarse_level> coarse{};
+		for (size_t c = 0; c < z; c++) coarse.push_back({ storage[c], lens[c] / lens[z] });
+
+		std::span<aa::peak const> const level = storage[z];
+		std::uniform_int_distribution<size_t> pos{ 0, level.size() };
+		for (int thresh : thresholds) for (bool backward : { false, true }) for (int k = 0; k < 200; k++) {
+			size_t const from = pos(rng);
+			auto const plain = aa::find_transient(level, from, backward, thresh),
+				fast = aa::find_transient(level, from, backward, thresh, coarse);
+			CHECK(plain == fast, "level %zu, threshold %d, from %zu %s: %lld with coarse levels, %lld without",
+				z, thresh, from, backward ? "backward" : "forward",
+				fast ? static_cast<long long>(*fast) : -1LL, plain ? static_cast<long long>(*plain) : -1LL);
+			if (failures > 20) return;
+		}
+	}
+}
+
+int main()
+{
+	// 87 BPM must not be doubled to 174 BPM.
+	double const tempos[] = { 87, 90, 120, 128, 140, 174 };
+	uint32_t const rates[] = { 44100, 48000 };
+	double const offsets[] = { 0.0, 0.137, 0.31 };
+
+	for (double bpm : tempos) for (uint32_t rate : rates) for (double offset : offsets)
+		check_track(rate, bpm, offset);
+	check_transients();
+
+	if (failures > 0) { std::printf("%d failures\n", failures); return 1; }
+	std::printf("all passed\n");
+	return 0;
+}
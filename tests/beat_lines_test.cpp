@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// `beat_lines::line_iterator` が `pos_from_beat()` と同じ位置を列挙することの確認．
+
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+
+#include "../beat_lines.hpp"
+
+namespace bl = enhanced_tl::BPM_Grid::beat_lines;
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; std::printf(__VA_ARGS__); std::printf("\n"); } } while (false)
+
+// "frames per beat" as in `BPM_Grid`, with tempo in BPM multiplied by 10'000.
+struct grid {
+	int64_t n, d; int32_t origin;
+	grid(int video_rate, int video_scale, int tempo, int beats_numer, int beats_denom, int subdiv, int32_t origin)
+		: n{ int64_t{ video_rate } * (600'000 * beats_numer) },
+		d{ int64_t{ video_scale } * (int64_t{ tempo } * beats_denom) * subdiv },
+		origin{ origin } {}
+};
+
+// every line in [pos_L, pos_R] must be enumerated once, in order, at `pos_from_beat()`.
+static void check_range(grid const& g, int32_t pos_L, int32_t pos_R)
+{
+	int64_t const first_beat = bl::beat_from_pos(pos_L - 1, g.n, g.d, g.origin) + 1;
+	int64_t expected = first_beat;
+	while (bl::pos_from_beat(expected, g.n, g.d, g.origin) < pos_L) expected++;
+
+	// the number of lines in the range, counted with `pos_from_beat()` alone.
+	int64_t num_lines = 0;
+	while (bl::pos_from_beat(expected + num_lines, g.n, g.d, g.origin) <= pos_R) num_lines++;
+
+	int64_t count = 0;
+	for (auto it = bl::line_iterator::first_in(g.n, g.d, g.origin, pos_L, pos_R);
+		it != std::default_sentinel; ++it, ++expected, ++count) {
+		auto const [beat, pos] = *it;
+		int32_t const ref = bl::pos_from_beat(beat, g.n, g.d, g.origin);
+		CHECK(beat == expected, "beat %lld, expected %lld (n=%lld d=%lld)",
+			(long long)beat, (long long)expected, (long long)g.n, (long long)g.d);
+		CHECK(pos == ref, "beat %lld at %d, pos_from_beat says %d (n=%lld d=%lld origin=%d)",
+			(long long)beat, pos, ref, (long long)g.n, (long long)g.d, g.origin);
+		CHECK(pos_L <= pos && pos <= pos_R, "beat %lld at %d out of [%d, %d]", (long long)beat, pos, pos_L, pos_R);
+		if (failures > 20) return;
+	}
+	CHECK(bl::pos_from_beat(expected, g.n, g.d, g.origin) > pos_R,
+		"line %lld at %d missing before %d", (long long)expected, bl::pos_from_beat(expected, g.n, g.d, g.origin), pos_R);
+	CHECK(count == num_lines, "%lld lines enumerated in [%d, %d], expected %lld (n=%lld d=%lld origin=%d)",
+		(long long)count, pos_L, pos_R, (long long)num_lines, (long long)g.n, (long long)g.d, g.origin);
+}
+
+int main()
+{
+	struct { int rate, scale; } const rates[] = {
+		{ 30000, 1001 }, { 24000, 1001 }, { 60000, 1001 }, { 25, 1 }, { 120, 1 },
+	};
+	int const tempos[] = { 1'200'000, 1'285'000, 1'740'000, 973'333, 600'001, 600'000 };
+	struct { int numer, denom, subdiv; } const divs[] = {
+		{ 1, 1, 1 }, { 1, 4, 1 }, { 1, 1, 3 }, { 4, 1, 1 }, { 1, 1, 7 }, { 1, 1, 64 },
+	};
+	int32_t const origins[] = { -7, 0, 1234 };
+
+	std::mt19937 rng{ 12345 };
+	for (auto [rate, scale] : rates) for (int tempo : tempos)
+	for (auto [numer, denom, subdiv] : divs) for (int32_t origin : origins) {
+		grid const g{ rate, scale, tempo, numer, denom, subdiv, origin };
+
+		// a long range across the origin: about 3 hours at 29.97 fps.
+		check_range(g, -5'000, 330'000);
+
+		// random windows like visible timeline ranges.
+		for (int i = 0; i < 50; i++) {
+			int32_t const L = static_cast<int32_t>(rng() % 2'000'000) - 100'000;
+			check_range(g, L, L + static_cast<int32_t>(rng() % 3'000));
+		}
+	}
+
+	// an empty range.
+	CHECK(bl::line_iterator::none() == std::default_sentinel, "none() is not empty");
+
+	if (failures > 0) { std::printf("%d failures\n", failures); return 1; }
+	std::printf("all passed\n");
+	return 0;
+}
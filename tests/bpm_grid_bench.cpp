@@ -0,0 +1,160 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+// `BPM_Grid::current_grid()` のキャッシュが，マウス移動やホイール操作 1 回ごとに省く計算の量を測るベンチマーク．
+// `bpm_grid.cpp` と同じ手順の拍数線の計算で，毎回グリッドを作る場合と，設定値を比べて使い回す場合を比べる．
+// キャッシュなしの場合はさらに `get_file_info()` を毎回呼んでいたが，AviUtl なしでは測れないので含まない．
+//
+//	bpm_grid_bench [--events 1000000] [--rounds 5] [--format json|csv]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+#include "../beat_lines.hpp"
+
+namespace bl = enhanced_tl::BPM_Grid::beat_lines;
+
+constexpr int one_bpm = 600'000;
+
+// the raw values of exedit and the file that a grid is made from.
+struct settings {
+	int32_t tempo, origin, num_beats, beats_numer, beats_denom, video_rate, video_scale;
+	bool operator==(settings const&) const = default;
+};
+
+// テンポマップの 1 区間．
+struct tempo_segment {
+	int32_t start, tempo;
+};
+
+// 区間 1 つ分のグリッド．`TempoGrid::piece` と同じ．
+struct piece {
+	int64_t fpb_n, fpb_d;
+	int32_t origin;
+	int64_t first_beat;
+};
+
+// `current_grid()` の `build_grid()` と同じ手順でグリッドを作る．
+static void build_grid(std::vector<piece>& pieces, settings const& s, std::vector<tempo_segment> const& tempo_map)
+{
+	auto const make = [&](int32_t origin, int32_t tempo) {
+		return piece{ static_cast<int64_t>(s.video_rate) * (one_bpm * s.beats_numer),
+			static_cast<int64_t>(s.video_scale) * (tempo * s.beats_denom), origin, 0 };
+	};
+
+	pieces.clear();
+	if (tempo_map.empty()) {
+		pieces.push_back(make(s.origin, s.tempo));
+		return;
+	}
+	for (auto const& seg : tempo_map) {
+		auto p = make(seg.start, seg.tempo);
+		if (!pieces.empty()) {
+			auto const& prev = pieces.back();
+			p.first_beat = prev.first_beat + bl::beat_from_pos(seg.start - 1, prev.fpb_n, prev.fpb_d, prev.origin) + 1;
+		}
+		pieces.push_back(p);
+	}
+}
+
+// the snapping of a mouse move, as `drags::Step_BPM` does with the grid.
+static int64_t snap(std::vector<piece> const& pieces, int32_t frame)
+{
+	auto it = std::ranges::upper_bound(pieces, frame, {}, &piece::origin);
+	if (it != pieces.begin()) --it;
+	int64_t const beat = bl::beat_from_pos(frame, it->fpb_n, it->fpb_d, it->origin);
+	return bl::pos_from_beat(beat, it->fpb_n, it->fpb_d, it->origin) +
+		bl::pos_from_beat(beat + 1, it->fpb_n, it->fpb_d, it->origin);
+}
+
+// `run(i)` を `n` 回ずつ `rounds` 回繰り返し，最も速かった回の 1 回あたりの時間を返す．
+static double measure(int n, int rounds, auto&& run)
+{
+	using clock = std::chrono::steady_clock;
+	int64_t volatile sink = 0;
+	double best = 0;
+	for (int r = 0; r < rounds; r++) {
+		int64_t acc = 0;
+		auto const t0 = clock::now();
+		for (int i = 0; i < n; i++) acc += run(i);
+		auto const t1 = clock::now();
+		sink = sink + acc;
+		double const ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+		if (r == 0 || ns < best) best = ns;
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	int num_events = 1'000'000, rounds = 5;
+	bool csv = false;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string_view const arg = argv[i];
+		if (arg == "--events") num_events = std::max(std::atoi(argv[i + 1]), 1);
+		else if (arg == "--rounds") rounds = std::max(std::atoi(argv[i + 1]), 1);
+		else if (arg == "--format") csv = std::string_view{ argv[i + 1] } == "csv";
+		else {
+			std::fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	// 29.97 fps, 128 BPM in 4/4.
+	settings const s{ 128 * 10'000, 0, 4, 1, 1, 30000, 1001 };
+
+	if (csv) std::printf("case,variant,segments,ns_per_op\n");
+	else std::printf("[\n");
+	bool first = true;
+	for (int num_segments : { 0, 4, 32 }) {
+		std::vector<tempo_segment> tempo_map{};
+		for (int k = 0; k < num_segments; k++) tempo_map.push_back({ 900 * k, (120 + k % 7 * 5) * 10'000 });
+
+		std::vector<piece> pieces{};
+		build_grid(pieces, s, tempo_map);
+		settings cached = s;
+		// read the values through memory on each event, as they are exedit's variables.
+		settings const* volatile source = &s;
+
+		struct { char const* variant; double ns; } const results[] = {
+			// builds the grid on every event, as before the cache.
+			{ "rebuild", measure(num_events, rounds, [&](int i) {
+				build_grid(pieces, s, tempo_map);
+				return snap(pieces, i % 30000);
+			}) },
+			// compares the raw values and reuses the grid.
+			{ "cached", measure(num_events, rounds, [&](int i) {
+				settings const curr = *source;
+				if (curr != cached) {
+					cached = curr;
+					build_grid(pieces, curr, tempo_map);
+				}
+				return snap(pieces, i % 30000);
+			}) },
+		};
+		for (auto const& r : results) {
+			if (csv) std::printf("step_bpm_event,%s,%d,%.2f\n", r.variant, num_segments, r.ns);
+			else std::printf("%s  {\"case\": \"step_bpm_event\", \"variant\": \"%s\", \"segments\": %d, \"ns_per_op\": %.2f}",
+				first ? "" : ",\n", r.variant, num_segments, r.ns);
+			first = false;
+		}
+	}
+	if (!csv) std::printf("\n]\n");
+	return 0;
+}
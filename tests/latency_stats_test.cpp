@@ -0,0 +1,57 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// `walkaround::latency_stats` が一連の操作ごとに遅延を集計し直すことの確認．
+
+#include <cstdint>
+#include <cstdio>
+
+#include "../latency_stats.hpp"
+
+using enhanced_tl::walkaround::latency_stats;
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; std::printf(__VA_ARGS__); std::printf("\n"); } } while (false)
+
+int main()
+{
+	latency_stats s{};
+
+	// a burst of key repeats every 33 ms, applied 5 ms after each message.
+	for (int t = 1000; t < 2000; t += 33) {
+		s.on_command(t + 2);
+		s.on_applied(t, t + 5);
+	}
+	CHECK(s.num_commands == 31 && s.num_applied == 31, "burst: %d commands, %d applied", s.num_commands, s.num_applied);
+	CHECK(s.last_lag == 5 && s.max_lag == 5, "burst: lag %d, max %d", s.last_lag, s.max_lag);
+
+	// coalesced commands: fewer applications, the last one lagging behind.
+	s.on_command(2000);
+	s.on_command(2010);
+	s.on_applied(2008, 2040);
+	CHECK(s.num_commands == 33 && s.num_applied == 32, "coalesced: %d commands, %d applied", s.num_commands, s.num_applied);
+	CHECK(s.last_lag == 32 && s.max_lag == 32, "coalesced: lag %d, max %d", s.last_lag, s.max_lag);
+
+	// a command after a pause starts a new burst.
+	s.on_command(2010 + latency_stats::burst_gap_ms);
+	CHECK(s.num_commands == 1 && s.num_applied == 0 && s.max_lag == 0,
+		"new burst: %d commands, %d applied, max %d", s.num_commands, s.num_applied, s.max_lag);
+
+	// the message time may come after the tick of the application; the lag is never negative.
+	s.on_applied(3000, 2990);
+	CHECK(s.last_lag == 0, "negative lag: %d", s.last_lag);
+
+	if (failures > 0) { std::printf("%d failures\n", failures); return 1; }
+	std::printf("all passed\n");
+	return 0;
+}
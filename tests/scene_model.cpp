@@ -0,0 +1,74 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+#include "scene_model.hpp"
+
+
+////////////////////////////////
+// メモリ上のシーン．
+////////////////////////////////
+namespace expt = enhanced_tl::test;
+
+template class enhanced_tl::timeline::core::search_index<expt::scene_model>;
+
+int expt::scene_model::add_object(int layer, int frame_begin, int frame_end, bool active)
+{
+	objs.push_back({ frame_begin, frame_end, -1, layer, active });
+	next.push_back(-1);
+	return static_cast<int>(objs.size()) - 1;
+}
+
+void expt::scene_model::build()
+{
+	int const n = static_cast<int>(objs.size());
+
+	// 中間点の繋がりの先頭を設定．誰の次でもないものが先頭．
+	std::vector<bool> has_prev(n, false);
+	for (int i = 0; i < n; i++) if (next[i] >= 0) has_prev[next[i]] = true;
+	for (auto& obj : objs) obj.index_midpt_leader = -1;
+	for (int i = 0; i < n; i++) {
+		if (has_prev[i] || next[i] < 0) continue;
+		for (int j = i; j >= 0; j = next[j]) objs[j].index_midpt_leader = i;
+	}
+
+	// レイヤー順，開始フレーム順に並べる．
+	sorted.clear();
+	for (auto& obj : objs) if (obj.layer >= 0) sorted.push_back(&obj);
+	std::ranges::stable_sort(sorted, [](object const* a, object const* b) {
+		return a->layer != b->layer ? a->layer < b->layer : a->frame_begin < b->frame_begin;
+	});
+
+	int j = 0;
+	for (int layer = 0; layer < tlc::num_layers; layer++) {
+		int const L = j;
+		while (j < static_cast<int>(sorted.size()) && sorted[j]->layer == layer) j++;
+		if (j > L) { begin_idx[layer] = L; end_idx[layer] = j - 1; }
+		else if (empty_ranges[layer].specified) {
+			begin_idx[layer] = empty_ranges[layer].begin;
+			end_idx[layer] = empty_ranges[layer].end;
+		}
+		else { begin_idx[layer] = j; end_idx[layer] = j - 1; }
+	}
+
+	serial++;
+}
+
+int expt::scene_model::obj_from_point(int x, int y) const
+{
+	namespace core = timeline::core;
+	return core::object_at_frame(*this, core::point_to_frame(*this, x), core::point_to_layer(*this, y));
+}
@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+
+#include "../timeline_index_core.hpp"
+#include "../timeline_core.hpp"
+
+
+////////////////////////////////
+// メモリ上のシーン．タイムライン検索を拡張編集なしで動かすためのもの．
+////////////////////////////////
+namespace enhanced_tl::test
+{
+	namespace tlc = timeline::constants;
+
+	/// @brief `ExEdit::Object` のうち，タイムライン検索が参照する部分．
+	struct model_object {
+		int32_t frame_begin, frame_end;
+		int32_t index_midpt_leader;	// 中間点の繋がりの先頭．中間点のない場合は `-1`．`build()` が設定する．
+		int32_t layer;				// `-1` の場合は現在のシーンにないオブジェクト．
+		bool active;				// 繋がりの先頭以外では参照されない．
+	};
+
+	/// @brief オブジェクトの列から拡張編集と同じ形式の表を作り，`timeline::core` の検索に渡せるようにしたシーン．
+	class scene_model {
+	public:
+		using object = model_object;
+
+		// 表示状態．
+		struct view_params {
+			int zoom_len = 10'000, h_scroll = 0, v_scroll = 0, layer_height = 20, width = 1000;
+		} view{};
+
+		// `false` でオブジェクトのドラッグ中とみなし，フレーム位置に依存する索引を使わせない．
+		bool settled = true;
+
+		std::array<bool, tlc::num_layers> hidden{}, locked{};
+
+		/// @brief オブジェクトを追加する．`build()` を呼ぶまで表には反映されない．
+		/// @return オブジェクトのインデックス．
+		int add_object(int layer, int frame_begin, int frame_end, bool active = true);
+
+		/// @brief `idx` の次に `idx_next` が中間点で繋がるようにする．
+		void link(int idx, int idx_next) { next[idx] = idx_next; }
+
+		/// @brief 空レイヤーの `layer_begin()`, `layer_end()` の値を指定する．`begin > end` であること．
+		/// 指定しないレイヤーは，直前のレイヤーの末尾に続く長さ 0 の区間になる．
+		void set_empty_range(int layer, int begin, int end) { empty_ranges[layer] = { begin, end, true }; }
+
+		/// @brief オブジェクトの表を作り直す．オブジェクトを変更したら呼ぶ．
+		void build();
+
+		std::vector<model_object> const& objects() const { return objs; }
+
+		// `timeline::core::scene_state` の実装．
+		object* const* sorted_objects() const { return sorted.data(); }
+		object const* object_array() const { return objs.data(); }
+		int layer_begin(int layer) const { return begin_idx[layer]; }
+		int layer_end(int layer) const { return end_idx[layer]; }
+		int next_object(int idx) const { return next[idx]; }
+		bool active_flag(object const* obj) const { return obj->active; }
+		bool layer_visible(int layer) const { return !hidden[layer]; }
+		bool layer_locked(int layer) const { return locked[layer]; }
+		timeline::index::generation current_generation() const { return { serial, 0, objs.data(), 0 }; }
+		bool frames_settled() const { return settled; }
+		timeline::core::search_index<scene_model>& index() const { return indices; }
+
+		// `timeline::core::view_state` の実装．
+		int zoom_len() const { return view.zoom_len; }
+		int h_scroll() const { return view.h_scroll; }
+		int v_scroll() const { return view.v_scroll; }
+		int layer_height() const { return view.layer_height; }
+		int timeline_width() const { return view.width; }
+		int obj_from_point(int x, int y) const;
+
+	private:
+		std::vector<model_object> objs{};
+		std::vector<int32_t> next{};
+		std::vector<object*> sorted{};
+		std::array<int32_t, tlc::num_layers> begin_idx{}, end_idx{};
+		struct empty_range { int32_t begin, end; bool specified; };
+		std::array<empty_range, tlc::num_layers> empty_ranges{};
+		uint32_t serial = 0;
+		mutable timeline::core::search_index<scene_model> indices{};
+	};
+}
+
+extern template class enhanced_tl::timeline::core::search_index<enhanced_tl::test::scene_model>;
@@ -0,0 +1,312 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+// タイムライン検索，座標変換，当たり判定の速度をメモリ上のシーンで測るベンチマーク．
+// 結果は JSON か CSV で出力するので，リリース間で比較できる．
+//
+//	timeline_bench [--objects 1000,10000,100000] [--layers 100] [--distribution uniform|skewed|single]
+//		[--chain-max 4] [--inactive 0.1] [--shuffle 1] [--queries 100000] [--rounds 5] [--seed 1] [--format json|csv]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scene_model.hpp"
+
+using enhanced_tl::test::scene_model;
+namespace core = enhanced_tl::timeline::core;
+namespace tl = enhanced_tl::timeline;
+namespace tlc = tl::constants;
+
+// シーンの生成条件．
+struct scene_params {
+	int num_objects = 1000;
+	int num_layers = tlc::num_layers;
+	std::string distribution = "uniform"; // how objects spread over layers.
+	int chain_max = 4;			// chains of mid-points have 1 to this many objects.
+	double inactive_ratio = 0.1;	// the ratio of inactive chains.
+	bool shuffle = true;		// stores objects in random order, as in a scene edited over time.
+	uint32_t seed = 1;
+};
+
+// 条件に従ってオブジェクトを並べたシーンを作る．
+static void generate_scene(scene_model& scene, scene_params const& p)
+{
+	std::mt19937 rng{ p.seed };
+
+	// assign the number of objects to each layer.
+	std::vector<double> weights(p.num_layers, 1.0);
+	if (p.distribution == "skewed")
+		for (int l = 0; l < p.num_layers; l++) weights[l] = 1.0 / (l + 1);
+	else if (p.distribution == "single")
+		std::fill(weights.begin() + 1, weights.end(), 0.0);
+	std::discrete_distribution<int> pick_layer{ weights.begin(), weights.end() };
+	std::vector<int> counts(p.num_layers, 0);
+	for (int i = 0; i < p.num_objects; i++) counts[pick_layer(rng)]++;
+
+	std::uniform_int_distribution<int> gap{ 0, 60 }, len{ 1, 240 }, chain_len{ 1, std::max(p.chain_max, 1) };
+	std::bernoulli_distribution inactive{ p.inactive_ratio };
+	struct entry { int layer, begin, end, prev; bool active; };
+	std::vector<entry> entries{};
+	for (int l = 0; l < p.num_layers; l++) {
+		int frame = gap(rng);
+		for (int n = counts[l]; n > 0; ) {
+			int const k = std::min(chain_len(rng), n);
+			bool const active = !inactive(rng);
+			for (int i = 0; i < k; i++) {
+				int const f = len(rng);
+				entries.push_back({ l, frame, frame + f - 1, i > 0 ? static_cast<int>(entries.size()) - 1 : -1, active });
+				frame += f;
+			}
+			n -= k;
+			frame += gap(rng);
+		}
+	}
+
+	// the order in the object array, which the sorted table points into.
+	std::vector<int> order(entries.size()), idx(entries.size());
+	for (int i = 0; i < static_cast<int>(order.size()); i++) order[i] = i;
+	if (p.shuffle) std::ranges::shuffle(order, rng);
+	for (int i : order) idx[i] = scene.add_object(entries[i].layer, entries[i].begin, entries[i].end, entries[i].active);
+	for (int i = 0; i < static_cast<int>(entries.size()); i++)
+		if (entries[i].prev >= 0) scene.link(idx[entries[i].prev], idx[i]);
+	scene.build();
+}
+
+// ヒープ確保の回数．検索がメモリ確保をしないことを確かめるためのもの．
+static constinit uint64_t num_allocs = 0;
+
+void* operator new(size_t size)
+{
+	num_allocs++;
+	if (void* const p = std::malloc(size > 0 ? size : 1)) return p;
+	throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// 1 つの測定結果．
+struct result {
+	std::string name, variant;
+	double ns_per_op;
+	double allocs_per_op;
+};
+
+// `run(i)` を `n` 回ずつ `rounds` 回繰り返し，最も速かった回の 1 回あたりの時間と，1 回あたりのヒープ確保の回数を返す．
+static std::pair<double, double> measure(int n, int rounds, auto&& run)
+{
+	using clock = std::chrono::steady_clock;
+	uint64_t volatile sink = 0;
+	for (int i = 0; i < std::min(n, 1000); i++) sink = sink + run(i); // warm up and build the indices.
+
+	double best = 0;
+	uint64_t const allocs_before = num_allocs;
+	for (int r = 0; r < rounds; r++) {
+		uint64_t acc = 0;
+		auto const t0 = clock::now();
+		for (int i = 0; i < n; i++) acc += run(i);
+		auto const t1 = clock::now();
+		sink = sink + acc;
+		double const ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+		if (r == 0 || ns < best) best = ns;
+	}
+	return { best, static_cast<double>(num_allocs - allocs_before) / (static_cast<double>(n) * rounds) };
+}
+
+// 検索の引数の列．測定中に乱数を作らないように前もって用意する．
+struct query {
+	int pos, pos_R, layer, x, y;
+};
+
+static std::vector<result> run_cases(scene_model& scene, scene_params const& p, int num_queries, int rounds)
+{
+	int scene_len = 1;
+	for (auto const& obj : scene.objects()) scene_len = std::max(scene_len, obj.frame_end + 1);
+
+	// show about 1,000 frames in 1,000 pixels, scrolled to the middle.
+	scene.view.zoom_len = 10'000;
+	scene.view.h_scroll = scene_len / 2;
+
+	std::mt19937 rng{ p.seed + 1 };
+	std::uniform_int_distribution<int> pos{ 0, scene_len + scene_len / 16 }, layer{ 0, p.num_layers - 1 },
+		width{ 0, 600 }, x{ 0, scene.view.width - 1 }, y{ 0, tlc::top_layer_area + 20 * scene.view.layer_height };
+	std::vector<query> qs(num_queries);
+	for (auto& q : qs) {
+		q.pos = pos(rng); q.pos_R = q.pos + width(rng); q.layer = layer(rng);
+		q.x = x(rng); q.y = y(rng);
+	}
+
+	std::vector<result> ret{};
+	// measures `run` under the given name and variant.
+	auto const add_variant = [&](char const* name, char const* variant, bool settled, auto&& run) {
+		scene.settled = settled;
+		auto const [ns, allocs] = measure(num_queries, rounds, run);
+		ret.push_back({ name, variant, ns, allocs });
+		scene.settled = true;
+	};
+	auto const add = [&](char const* name, auto&& run, bool uses_index = true) {
+		// "indexed" uses the caches of `search_index`; "direct" disables them as during object drags.
+		if (!uses_index) add_variant(name, "-", true, run);
+		else {
+			add_variant(name, "indexed", true, run);
+			add_variant(name, "direct", false, run);
+		}
+	};
+
+	// the lowest level of the searches, on the packed begin frames or through the object pointers.
+	add_variant("find_nearest_index", "packed", true, [&](int i) {
+		return core::detail::find_nearest_index(scene, qs[i].pos, scene.layer_begin(qs[i].layer), scene.layer_end(qs[i].layer));
+	});
+	add_variant("find_nearest_index", "pointer", true, [&](int i) {
+		int const idx_L = scene.layer_begin(qs[i].layer), idx_R = scene.layer_end(qs[i].layer);
+		return idx_L > idx_R ? idx_L - 1 : core::detail::find_nearest_index_direct(scene, qs[i].pos, idx_L, idx_R);
+	});
+
+	add("find_adjacent_left", [&](int i) {
+		return core::find_adjacent_left(scene, qs[i].pos, qs[i].layer, true, true);
+	});
+	add("find_adjacent_right", [&](int i) {
+		return core::find_adjacent_right(scene, qs[i].pos, qs[i].layer, true, true);
+	});
+	// the scene-wide searches, using the merged boundary index or stepping each layer.
+	// "per_layer" keeps the per-layer indices, as the loop did when the merged index was added.
+	auto const left_scene = [&](int i) {
+		return core::find_adjacent_left_scene(scene, qs[i].pos, true, true, true);
+	};
+	add_variant("find_adjacent_left_scene", "indexed", true, left_scene);
+	add_variant("find_adjacent_left_scene", "per_layer", true, [&](int i) {
+		return core::detail::find_adjacent_left_scene_direct(scene, qs[i].pos, true, true, true);
+	});
+	add_variant("find_adjacent_left_scene", "direct", false, left_scene);
+	auto const right_scene = [&](int i) {
+		return core::find_adjacent_right_scene(scene, qs[i].pos, true, true, true, scene_len);
+	};
+	add_variant("find_adjacent_right_scene", "indexed", true, right_scene);
+	add_variant("find_adjacent_right_scene", "per_layer", true, [&](int i) {
+		return core::detail::find_adjacent_right_scene_direct(scene, qs[i].pos, true, true, true, scene_len);
+	});
+	add_variant("find_adjacent_right_scene", "direct", false, right_scene);
+	add("find_interval", [&](int i) {
+		auto const [l, r] = core::find_interval(scene, qs[i].pos, qs[i].layer, false, true);
+		return l + r;
+	});
+	add("object_at_frame", [&](int i) {
+		return core::object_at_frame(scene, qs[i].pos, qs[i].layer);
+	});
+	add("objects_in_interval_view", [&](int i) {
+		size_t sum = 0;
+		for (size_t idx : core::objects_in_interval_view(scene, qs[i].pos, qs[i].pos_R, qs[i].layer, true)) sum += idx;
+		return sum;
+	});
+	add("objects_in_interval_layers", [&](int i) {
+		// as the callback form of `timeline::objects_in_interval()` sweeps 10 layers.
+		size_t sum = 0;
+		for (int layer = qs[i].layer / 10 * 10, end = std::min(layer + 10, p.num_layers); layer < end; layer++) {
+			for (size_t idx : core::objects_in_interval_view(scene, qs[i].pos, qs[i].pos_R, layer, true)) sum += idx;
+		}
+		return sum;
+	});
+	add("objects_in_interval", [&](int i) {
+		// as `timeline::objects_in_interval()` copies the view into a vector.
+		auto const range = core::objects_in_interval_view(scene, qs[i].pos, qs[i].pos_R, qs[i].layer, true);
+		std::vector<size_t> v{};
+		v.reserve(range.size());
+		for (size_t idx : range) v.push_back(idx);
+		return v.size();
+	});
+	add("point_to_frame", [&](int i) {
+		return core::point_to_frame(scene, qs[i].x);
+	}, false);
+	add("point_from_frame", [&](int i) {
+		return core::point_from_frame(scene, qs[i].pos);
+	}, false);
+	add("area_from_point", [&](int i) {
+		return static_cast<int>(core::area_from_point(scene, qs[i].x, qs[i].y, tl::area_obj_detection::exact));
+	});
+	return ret;
+}
+
+static std::vector<int> parse_list(char const* s)
+{
+	std::vector<int> ret{};
+	for (char* end; *s != '\0'; s = *end == ',' ? end + 1 : end) {
+		ret.push_back(static_cast<int>(std::strtol(s, &end, 10)));
+		if (end == s) break;
+	}
+	return ret;
+}
+
+int main(int argc, char** argv)
+{
+	scene_params p{};
+	std::vector<int> object_counts{ 1000, 10000, 100000 };
+	int num_queries = 100'000, rounds = 5;
+	bool csv = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view const arg = argv[i];
+		char const* const val = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (val == nullptr) {
+			std::fprintf(stderr, "missing value for %s\n", argv[i]);
+			return 2;
+		}
+		i++;
+		if (arg == "--objects") object_counts = parse_list(val);
+		else if (arg == "--layers") p.num_layers = std::clamp(std::atoi(val), 1, tlc::num_layers);
+		else if (arg == "--distribution") p.distribution = val;
+		else if (arg == "--chain-max") p.chain_max = std::atoi(val);
+		else if (arg == "--inactive") p.inactive_ratio = std::clamp(std::atof(val), 0.0, 1.0);
+		else if (arg == "--queries") num_queries = std::max(std::atoi(val), 1);
+		else if (arg == "--rounds") rounds = std::max(std::atoi(val), 1);
+		else if (arg == "--shuffle") p.shuffle = std::atoi(val) != 0;
+		else if (arg == "--seed") p.seed = static_cast<uint32_t>(std::strtoul(val, nullptr, 10));
+		else if (arg == "--format") csv = std::string_view{ val } == "csv";
+		else {
+			std::fprintf(stderr, "unknown option %s\n", argv[i - 1]);
+			return 2;
+		}
+	}
+
+	if (csv) std::printf("case,variant,objects,layers,distribution,chain_max,inactive_ratio,queries,ns_per_op,allocs_per_op\n");
+	else std::printf("[\n");
+	bool first = true;
+	for (int n : object_counts) {
+		p.num_objects = n;
+		scene_model scene{};
+		generate_scene(scene, p);
+		for (auto const& r : run_cases(scene, p, num_queries, rounds)) {
+			if (csv)
+				std::printf("%s,%s,%d,%d,%s,%d,%.3f,%d,%.2f,%.3f\n", r.name.c_str(), r.variant.c_str(),
+					n, p.num_layers, p.distribution.c_str(), p.chain_max, p.inactive_ratio, num_queries, r.ns_per_op, r.allocs_per_op);
+			else {
+				std::printf("%s  {\"case\": \"%s\", \"variant\": \"%s\", \"objects\": %d, \"layers\": %d, "
+					"\"distribution\": \"%s\", \"chain_max\": %d, \"inactive_ratio\": %.3f, \"queries\": %d, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f}",
+					first ? "" : ",\n", r.name.c_str(), r.variant.c_str(),
+					n, p.num_layers, p.distribution.c_str(), p.chain_max, p.inactive_ratio, num_queries, r.ns_per_op, r.allocs_per_op);
+			}
+			first = false;
+		}
+	}
+	if (!csv) std::printf("\n]\n");
+	return 0;
+}
@@ -0,0 +1,478 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+// タイムライン検索をメモリ上のランダムなシーンで総当たりの検索と照合する．
+// 空レイヤーの表し方，中間点，無効オブジェクトの連なりを含むシーンを作り，
+// 食い違いが見つかったらシーンを縮小してから報告する．
+//
+//	timeline_fuzz_test [num_scenes] [seed]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "scene_model.hpp"
+
+using enhanced_tl::test::scene_model;
+namespace core = enhanced_tl::timeline::core;
+namespace idx = enhanced_tl::timeline::index;
+namespace tlc = enhanced_tl::timeline::constants;
+
+static int failures = 0;
+
+////////////////////////////////
+// シーンの記述．縮小しやすいように，オブジェクトの位置は直前との間隔で表す．
+////////////////////////////////
+struct chain_spec {
+	int layer;
+	int gap;					// frames after the previous chain in the same layer.
+	std::vector<int> lengths;	// the lengths of the objects in the chain.
+	std::vector<bool> flags;	// the active flags of the objects. only the head's one counts.
+};
+
+// how `layer_begin()` and `layer_end()` look for an empty layer.
+enum class empty_kind : uint8_t { next, zero, negative, end_of_table, far, count };
+
+struct scene_spec {
+	std::vector<chain_spec> chains{}; // chains in the same layer are placed in this order.
+	std::array<bool, tlc::num_layers> hidden{}, locked{};
+	std::array<empty_kind, tlc::num_layers> empty{};
+	int num_foreign = 0;	// objects outside the current scene.
+	int extra_len = 0;		// the scene length minus the end of the last object.
+	uint32_t order_seed = 0;	// shuffles the object array.
+};
+
+static scene_spec random_spec(std::mt19937& rng)
+{
+	scene_spec spec{};
+	auto const uniform = [&](int a, int b) { return std::uniform_int_distribution<int>{ a, b }(rng); };
+	auto const chance = [&](double p) { return std::bernoulli_distribution{ p }(rng); };
+
+	// a few layers anywhere in 0--99, including the ends.
+	int const num_layers = uniform(1, 6);
+	for (int n = 0; n < num_layers; n++) {
+		int const layer = chance(0.2) ? (chance(0.5) ? 0 : tlc::num_layers - 1) : uniform(0, tlc::num_layers - 1);
+		bool active = !chance(0.3);
+		for (int c = uniform(0, 6); c > 0; c--) {
+			// inactive objects come in runs.
+			if (chance(0.3)) active = !active;
+			chain_spec ch{ layer, chance(0.3) ? 0 : uniform(1, 6), {}, {} };
+			for (int k = chance(0.5) ? 1 : uniform(2, 4); k > 0; k--) {
+				ch.lengths.push_back(uniform(1, 6));
+				ch.flags.push_back(chance(0.5));
+			}
+			ch.flags[0] = active;
+			spec.chains.push_back(std::move(ch));
+		}
+	}
+	for (int l = 0; l < tlc::num_layers; l++) {
+		spec.hidden[l] = chance(0.2);
+		spec.locked[l] = chance(0.2);
+		spec.empty[l] = static_cast<empty_kind>(uniform(0, static_cast<int>(empty_kind::count) - 1));
+	}
+	spec.num_foreign = chance(0.5) ? 0 : uniform(1, 4);
+	spec.extra_len = uniform(-3, 5);
+	spec.order_seed = rng();
+	return spec;
+}
+
+static void print_spec(scene_spec const& spec)
+{
+	for (auto const& ch : spec.chains) {
+		std::printf("  layer %d: gap %d, %s, lengths", ch.layer, ch.gap, ch.flags[0] ? "active" : "inactive");
+		for (int len : ch.lengths) std::printf(" %d", len);
+		std::printf("\n");
+	}
+	for (int l = 0; l < tlc::num_layers; l++) {
+		if (spec.hidden[l] || spec.locked[l] || spec.empty[l] != empty_kind::next)
+			std::printf("  layer %d:%s%s empty kind %d\n", l, spec.hidden[l] ? " hidden," : "",
+				spec.locked[l] ? " locked," : "", static_cast<int>(spec.empty[l]));
+	}
+	std::printf("  %d foreign objects, extra length %d, order seed %u\n", spec.num_foreign, spec.extra_len, spec.order_seed);
+}
+
+////////////////////////////////
+// 総当たりで検索するための参照モデル．
+////////////////////////////////
+struct ref_object {
+	int layer, begin, end;
+	int head, tail, prev, pos, count; // model indices of the chain members, as `index::chain_info`.
+	bool active; // of the chain.
+};
+
+struct reference {
+	std::vector<ref_object> objs{};	// indexed by the model index.
+	std::array<std::vector<int>, tlc::num_layers> layers{}; // model indices in each layer, left to right.
+	int scene_len = 1;
+
+	// boundaries in a layer that are not skipped, in ascending order.
+	std::vector<int> boundaries(int layer, bool skip_midpoints, bool skip_inactives) const
+	{
+		std::vector<int> ret{};
+		for (int i : layers[layer]) {
+			auto const& o = objs[i];
+			if (skip_inactives && !o.active) continue;
+			if (!skip_midpoints || o.pos == 0) ret.push_back(o.begin);
+			if (!skip_midpoints || o.pos == o.count - 1) ret.push_back(o.end + 1);
+		}
+		std::ranges::sort(ret);
+		return ret;
+	}
+};
+
+// builds the model and the reference from the spec.
+static void build(scene_spec const& spec, scene_model& model, reference& ref)
+{
+	// lay out the chains and collect the objects.
+	struct entry { int layer, begin, end, chain, pos; bool flag; };
+	std::vector<entry> entries{};
+	std::array<int, tlc::num_layers> frame{};
+	for (int c = 0; c < static_cast<int>(spec.chains.size()); c++) {
+		auto const& ch = spec.chains[c];
+		int& f = frame[ch.layer];
+		f += ch.gap;
+		for (int k = 0; k < static_cast<int>(ch.lengths.size()); k++) {
+			entries.push_back({ ch.layer, f, f + ch.lengths[k] - 1, c, k, ch.flags[k] });
+			f += ch.lengths[k];
+		}
+	}
+	int const num_in_scene = static_cast<int>(entries.size());
+	for (int i = 0; i < spec.num_foreign; i++)
+		entries.push_back({ -1, 3 * i, 3 * i + 2, -1, 0, true });
+
+	// add them in a shuffled order, so the object array is not sorted.
+	std::vector<int> order(entries.size());
+	for (int i = 0; i < static_cast<int>(order.size()); i++) order[i] = i;
+	std::ranges::shuffle(order, std::mt19937{ spec.order_seed });
+	std::vector<int> model_idx(entries.size());
+	ref.objs.assign(entries.size(), {});
+	for (int i : order) {
+		auto const& e = entries[i];
+		model_idx[i] = model.add_object(e.layer, e.begin, e.end, e.flag);
+	}
+
+	// link the chains and fill the reference.
+	for (auto& l : ref.layers) l.clear();
+	int last_end = 0;
+	for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+		auto const& e = entries[i];
+		auto& o = ref.objs[model_idx[i]];
+		o = { e.layer, e.begin, e.end, model_idx[i], model_idx[i], -1, 0, 1, e.flag };
+		if (e.chain < 0) continue;
+
+		int const n = static_cast<int>(spec.chains[e.chain].lengths.size()), i0 = i - e.pos;
+		o = { e.layer, e.begin, e.end, model_idx[i0], model_idx[i0 + n - 1], e.pos > 0 ? model_idx[i - 1] : -1,
+			e.pos, n, static_cast<bool>(spec.chains[e.chain].flags[0]) };
+		if (e.pos > 0) model.link(model_idx[i - 1], model_idx[i]);
+		ref.layers[e.layer].push_back(model_idx[i]);
+		last_end = std::max(last_end, e.end + 1);
+	}
+	ref.scene_len = std::max(last_end + spec.extra_len, 1);
+
+	// the empty layers.
+	for (int l = 0; l < tlc::num_layers; l++) {
+		switch (spec.empty[l]) {
+		case empty_kind::zero:			model.set_empty_range(l, 0, -1); break;
+		case empty_kind::negative:		model.set_empty_range(l, -1, -2); break;
+		case empty_kind::end_of_table:	model.set_empty_range(l, num_in_scene, num_in_scene - 1); break;
+		case empty_kind::far:			model.set_empty_range(l, num_in_scene + 1, 0); break;
+		default: break;
+		}
+	}
+	model.hidden = spec.hidden;
+	model.locked = spec.locked;
+	model.build();
+}
+
+////////////////////////////////
+// 照合．
+////////////////////////////////
+// compares all the queries, returning the first mismatch, or an empty string.
+static std::string first_mismatch(scene_spec const& spec)
+{
+	scene_model model{};
+	reference ref{};
+	build(spec, model, ref);
+
+	std::string msg{};
+	auto const fail = [&](char const* fmt, auto... args) {
+		if (!msg.empty()) return;
+		char buf[256];
+		std::snprintf(buf, sizeof(buf), fmt, args...);
+		msg = buf;
+	};
+	int const len = ref.scene_len, pos_min = -2, pos_max = len + 2;
+
+	// layers to query: all the nonempty ones and a few empty ones.
+	std::vector<int> query_layers{};
+	for (int l = 0; l < tlc::num_layers; l++)
+		if (!ref.layers[l].empty() || l % 37 == 0 || l == tlc::num_layers - 1) query_layers.push_back(l);
+
+	for (bool const settled : { true, false, true }) {
+		model.settled = settled;
+		char const* const mode = settled ? "indexed" : "direct";
+
+		// per-layer searches.
+		for (int layer : query_layers) {
+			auto const& objs = ref.layers[layer];
+			for (bool const sm : { false, true }) for (bool const si : { false, true }) {
+				auto const b = ref.boundaries(layer, sm, si);
+				for (int pos = pos_min; pos <= pos_max; pos++) {
+					int exp_l = 0, exp_l_incl = 0, exp_r = -1;
+					for (int f : b) {
+						if (f < pos) exp_l = f;
+						if (f <= pos) exp_l_incl = f;
+						if (f > pos && exp_r < 0) exp_r = f;
+					}
+					if (int const got = core::find_adjacent_left(model, pos, layer, sm, si); got != exp_l)
+						fail("%s find_adjacent_left(%d, %d, %d, %d) = %d, expected %d", mode, pos, layer, sm, si, got, exp_l);
+					if (int const got = core::find_adjacent_right(model, pos, layer, sm, si); got != exp_r)
+						fail("%s find_adjacent_right(%d, %d, %d, %d) = %d, expected %d", mode, pos, layer, sm, si, got, exp_r);
+					if (auto const [l, r] = core::find_interval(model, pos, layer, sm, si); l != exp_l_incl || r != exp_r)
+						fail("%s find_interval(%d, %d, %d, %d) = {%d, %d}, expected {%d, %d}", mode, pos, layer, sm, si, l, r, exp_l_incl, exp_r);
+				}
+			}
+
+			for (int pos = pos_min; pos <= pos_max; pos++) {
+				int exp = -1, exp_sorted = -1;
+				for (int j = 0; j < static_cast<int>(objs.size()); j++) {
+					auto const& o = ref.objs[objs[j]];
+					if (o.begin <= pos) exp_sorted = model.layer_begin(layer) + j;
+					if (o.begin <= pos && pos <= o.end) exp = objs[j];
+				}
+				if (int const got = core::object_at_frame(model, pos, layer); got != exp)
+					fail("%s object_at_frame(%d, %d) = %d, expected %d", mode, pos, layer, got, exp);
+				if (int const got = core::find_left_sorted_index(model, pos, layer); got != exp_sorted)
+					fail("%s find_left_sorted_index(%d, %d) = %d, expected %d", mode, pos, layer, got, exp_sorted);
+
+				// intervals of various widths starting here.
+				for (int w : { 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89 }) {
+					int const pos_R = pos + w;
+					for (bool const inclusive : { false, true }) {
+						std::vector<size_t> exp_objs{};
+						for (int i : objs) {
+							auto const& o = ref.objs[i];
+							if (inclusive ? (o.begin <= pos_R && o.end >= pos) : (o.begin >= pos && o.end < pos_R))
+								exp_objs.push_back(i);
+						}
+						std::vector<size_t> got{};
+						for (size_t i : core::objects_in_interval_view(model, pos, pos_R, layer, inclusive)) got.push_back(i);
+						if (got != exp_objs)
+							fail("%s objects_in_interval_view(%d, %d, %d, %d): %zu objects, expected %zu",
+								mode, pos, pos_R, layer, inclusive, got.size(), exp_objs.size());
+					}
+				}
+			}
+		}
+
+		// scene-wide searches.
+		for (bool const sm : { false, true }) for (bool const si : { false, true }) for (bool const sh : { false, true }) {
+			std::vector<int> b{};
+			for (int l = 0; l < tlc::num_layers; l++) {
+				if (sh && spec.hidden[l]) continue;
+				auto const bl = ref.boundaries(l, sm, si);
+				b.insert(b.end(), bl.begin(), bl.end());
+			}
+			std::ranges::sort(b);
+			for (int pos = pos_min; pos <= pos_max; pos++) {
+				int exp_l = 0, exp_r = len - 1;
+				for (int f : b) {
+					if (f < pos) exp_l = f;
+					if (f > pos) { exp_r = std::min(exp_r, f); break; }
+				}
+				if (int const got = core::find_adjacent_left_scene(model, pos, sm, si, sh); got != exp_l)
+					fail("%s find_adjacent_left_scene(%d, %d, %d, %d) = %d, expected %d", mode, pos, sm, si, sh, got, exp_l);
+				if (int const got = core::find_adjacent_right_scene(model, pos, sm, si, sh, len); got != exp_r)
+					fail("%s find_adjacent_right_scene(%d, %d, %d, %d, %d) = %d, expected %d", mode, pos, sm, si, sh, len, got, exp_r);
+			}
+		}
+
+		// layers and chains.
+		std::vector<uint8_t> exp_layers{};
+		idx::layer_states exp_states{};
+		for (int l = 0; l < tlc::num_layers; l++) {
+			if (!ref.layers[l].empty()) { exp_layers.push_back(static_cast<uint8_t>(l)); exp_states.nonempty.set(l); }
+			if (!spec.hidden[l]) exp_states.visible.set(l);
+			if (spec.locked[l]) exp_states.locked.set(l);
+		}
+		if (auto const got = core::nonempty_layers(model); !std::ranges::equal(got, exp_layers))
+			fail("%s nonempty_layers(): %zu layers, expected %zu", mode, got.size(), exp_layers.size());
+		if (auto const& got = model.index().current_layer_states(model);
+			got.visible != exp_states.visible || got.locked != exp_states.locked || got.nonempty != exp_states.nonempty)
+			fail("%s current_layer_states() mismatch", mode);
+
+		for (int i = 0; i < static_cast<int>(ref.objs.size()); i++) {
+			auto const& o = ref.objs[i];
+			auto const* const obj = &model.object_array()[i];
+			if (o.layer < 0) {
+				if (model.index().chain_of(model, i))
+					fail("%s chain_of(%d) for an object outside the scene", mode, i);
+				continue;
+			}
+			if (core::is_active(model, obj) != o.active)
+				fail("%s is_active(%d) = %d", mode, i, !o.active);
+			if (int const got = core::chain_begin(model, obj); got != ref.objs[o.head].begin)
+				fail("%s chain_begin(%d) = %d, expected %d", mode, i, got, ref.objs[o.head].begin);
+			if (int const got = core::chain_end(model, obj); got != ref.objs[o.tail].end)
+				fail("%s chain_end(%d) = %d, expected %d", mode, i, got, ref.objs[o.tail].end);
+			if (auto const got = model.index().chain_of(model, i);
+				!got || got->head != o.head || got->tail != o.tail || got->prev != o.prev || got->pos != o.pos || got->count != o.count)
+				fail("%s chain_of(%d) mismatch", mode, i);
+		}
+		for (int i : { -1, static_cast<int>(ref.objs.size()) })
+			if (model.index().chain_of(model, i)) fail("%s chain_of(%d) out of range", mode, i);
+
+		// the rest of the index, only available while settled.
+		auto& index = model.index();
+		if (!settled) {
+			if (index.sorted_frame_begins(model) != nullptr || index.gaps_of_layer(model, 0) || index.largest_gap(model, 0) ||
+				index.find_gap(model, 0, 0, 1) || index.prev_active_sorted_index(model, 0) || index.nonempty_layers(model))
+				fail("%s index available during drags", mode);
+			continue;
+		}
+		for (int layer : query_layers) {
+			auto const& objs = ref.layers[layer];
+
+			std::vector<idx::free_interval> exp_gaps{};
+			int prev_end = 0;
+			for (int i : objs) {
+				exp_gaps.push_back({ prev_end, ref.objs[i].begin });
+				prev_end = ref.objs[i].end + 1;
+			}
+			exp_gaps.push_back({ prev_end, -1 });
+			auto const gaps = index.gaps_of_layer(model, layer);
+			if (!gaps || !std::ranges::equal(*gaps, exp_gaps, [](auto const& a, auto const& b) { return a.begin == b.begin && a.end == b.end; }))
+				fail("%s gaps_of_layer(%d) mismatch", mode, layer);
+
+			idx::free_interval exp_largest{ 0, 0 };
+			for (int k = 1; k + 1 < static_cast<int>(exp_gaps.size()); k++)
+				if (exp_gaps[k].end - exp_gaps[k].begin > exp_largest.end - exp_largest.begin) exp_largest = exp_gaps[k];
+			if (auto const got = index.largest_gap(model, layer); !got || got->begin != exp_largest.begin || got->end != exp_largest.end)
+				fail("%s largest_gap(%d) mismatch", mode, layer);
+
+			for (int frame = 0; frame <= pos_max; frame++) {
+				for (int need : { 1, 2, 3, 5, 8 }) {
+					idx::free_interval exp{};
+					for (auto const& g : exp_gaps) {
+						int const b = std::max(g.begin, frame);
+						if (g.end < 0 || g.end - b >= need) { exp = { b, g.end }; break; }
+					}
+					if (auto const got = index.find_gap(model, layer, frame, need); !got || got->begin != exp.begin || got->end != exp.end)
+						fail("%s find_gap(%d, %d, %d) = {%d, %d}, expected {%d, %d}", mode, layer, frame, need,
+							got ? got->begin : 0, got ? got->end : 0, exp.begin, exp.end);
+				}
+			}
+
+			auto const* const begins = index.sorted_frame_begins(model);
+			for (int j = 0; j < static_cast<int>(objs.size()); j++) {
+				int const s = model.layer_begin(layer) + j;
+				if (begins == nullptr || begins[s] != ref.objs[objs[j]].begin)
+					fail("%s sorted_frame_begins()[%d] mismatch", mode, s);
+
+				int exp_prev = -1, exp_next = -1;
+				for (int k = 0; k <= j; k++) if (ref.objs[objs[k]].active) exp_prev = model.layer_begin(layer) + k;
+				for (int k = static_cast<int>(objs.size()) - 1; k >= j; k--) if (ref.objs[objs[k]].active) exp_next = model.layer_begin(layer) + k;
+				if (auto const got = index.prev_active_sorted_index(model, s); got != exp_prev)
+					fail("%s prev_active_sorted_index(%d) = %d, expected %d", mode, s, got.value_or(-9), exp_prev);
+				if (auto const got = index.next_active_sorted_index(model, s); got != exp_next)
+					fail("%s next_active_sorted_index(%d) = %d, expected %d", mode, s, got.value_or(-9), exp_next);
+			}
+		}
+	}
+	return msg;
+}
+
+////////////////////////////////
+// 縮小．
+////////////////////////////////
+// simplifications of the spec, tried in this order.
+static std::vector<scene_spec> shrink_candidates(scene_spec const& spec)
+{
+	std::vector<scene_spec> ret{};
+	auto const with = [&](auto&& change) { auto s = spec; change(s); ret.push_back(std::move(s)); };
+
+	for (size_t c = 0; c < spec.chains.size(); c++)
+		with([&](scene_spec& s) { s.chains.erase(s.chains.begin() + c); });
+	for (size_t c = 0; c < spec.chains.size(); c++) {
+		auto const& ch = spec.chains[c];
+		if (ch.lengths.size() > 1) {
+			with([&](scene_spec& s) { s.chains[c].lengths.pop_back(); s.chains[c].flags.pop_back(); });
+			with([&](scene_spec& s) { s.chains[c].lengths.erase(s.chains[c].lengths.begin()); s.chains[c].flags.erase(s.chains[c].flags.begin()); });
+		}
+		if (ch.gap > 0) with([&](scene_spec& s) { s.chains[c].gap /= 2; });
+		for (size_t k = 0; k < ch.lengths.size(); k++) {
+			if (ch.lengths[k] > 1) with([&](scene_spec& s) { s.chains[c].lengths[k] /= 2; });
+			if (k > 0 && ch.flags[k] != ch.flags[0]) with([&](scene_spec& s) { s.chains[c].flags[k] = s.chains[c].flags[0]; });
+		}
+		if (!ch.flags[0]) with([&](scene_spec& s) { s.chains[c].flags[0] = true; });
+	}
+	if (spec.num_foreign > 0) with([](scene_spec& s) { s.num_foreign = 0; });
+	if (spec.extra_len != 0) with([](scene_spec& s) { s.extra_len = 0; });
+	if (spec.order_seed != 0) with([](scene_spec& s) { s.order_seed = 0; });
+	for (int l = 0; l < tlc::num_layers; l++) {
+		if (spec.hidden[l]) with([&](scene_spec& s) { s.hidden[l] = false; });
+		if (spec.locked[l]) with([&](scene_spec& s) { s.locked[l] = false; });
+		if (spec.empty[l] != empty_kind::next) with([&](scene_spec& s) { s.empty[l] = empty_kind::next; });
+	}
+	return ret;
+}
+
+// greedily applies simplifications as long as the mismatch persists.
+static std::pair<scene_spec, std::string> shrink(scene_spec spec, std::string msg)
+{
+	for (bool changed = true; changed; ) {
+		changed = false;
+		for (auto& cand : shrink_candidates(spec)) {
+			if (auto m = first_mismatch(cand); !m.empty()) {
+				spec = std::move(cand);
+				msg = std::move(m);
+				changed = true;
+				break;
+			}
+		}
+	}
+	return { std::move(spec), std::move(msg) };
+}
+
+int main(int argc, char** argv)
+{
+	int const num_scenes = argc > 1 ? std::atoi(argv[1]) : 300;
+	uint32_t const seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 20250101;
+
+	std::mt19937 rng{ seed };
+	for (int n = 0; n < num_scenes && failures < 3; n++) {
+		auto const spec = random_spec(rng);
+		auto msg = first_mismatch(spec);
+		if (msg.empty()) continue;
+
+		failures++;
+		auto const [minimal, min_msg] = shrink(spec, std::move(msg));
+		std::printf("scene %d (seed %u): %s\nminimized scene:\n", n, seed, min_msg.c_str());
+		print_spec(minimal);
+	}
+
+	if (failures > 0) {
+		std::printf("%d failures\n", failures);
+		return 1;
+	}
+	std::printf("all passed\n");
+	return 0;
+}
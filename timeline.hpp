@@ -16,6 +16,8 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 #include <algorithm>
 #include <tuple>
 #include <vector>
+#include <span>
+#include <concepts>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -24,6 +26,8 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 using byte = uint8_t;
 #include <exedit.hpp>
 
+#include "timeline_core.hpp"
+
 
 ////////////////////////////////
 // タイムライン操作．
@@ -66,6 +70,23 @@ namespace enhanced_tl::timeline
 		return 0 <= pos && pos < len ? pos : len - 1;
 	}
 
+	/// @brief 全レイヤーから指定された位置より左にある最も近い境界を探す．
+	/// @param pos 指定位置，フレーム単位．
+	/// @param skip_midpoints 中間点を無視するかどうか．
+	/// @param skip_inactives 無効オブジェクトを無視するかどうか．
+	/// @param skip_hidden_layers 非表示レイヤーを無視するかどうか．
+	/// @return 検索結果のフレーム位置．
+	int find_adjacent_left_scene(int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers);
+
+	/// @brief 全レイヤーから指定された位置より右にある最も近い境界を探す．
+	/// @param pos 指定位置，フレーム単位．
+	/// @param skip_midpoints 中間点を無視するかどうか．
+	/// @param skip_inactives 無効オブジェクトを無視するかどうか．
+	/// @param skip_hidden_layers 非表示レイヤーを無視するかどうか．
+	/// @param len シーンの長さ，フレーム単位．
+	/// @return 検索結果のフレーム位置．
+	int find_adjacent_right_scene(int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers, int len);
+
 	/// @brief 指定フレームの左右にある境界点を検索する．指定フレームはオブジェクトの範囲内とは限らない．
 	/// @param pos 指定位置，フレーム単位．
 	/// @param layer 検索対象のレイヤー．
@@ -80,13 +101,73 @@ namespace enhanced_tl::timeline
 	/// @return オブジェクトのインデックス．`-1` の場合はそのフレームにオブジェクトなし．
 	int object_at_frame(int pos, int layer);
 
+	/// @brief オブジェクトのあるレイヤーを上から順に並べたものを取得する．
+	/// @return レイヤーの列．次に編集されるまで有効．
+	std::span<uint8_t const> nonempty_layers();
+
+	/// @brief 指定フレームにあるオブジェクトを全レイヤーから探し，レイヤーの順に列挙する．空のレイヤーは調べない．
+	/// @param pos 指定フレーム．
+	/// @param from_bottom `true` で下のレイヤーから，`false` で上のレイヤーから列挙する．
+	/// @param callback オブジェクトのインデックスとレイヤーを受け取る関数．`false` を返すと列挙を打ち切る．
+	inline void objects_at_frame(int pos, bool from_bottom, std::predicate<int, int> auto&& callback)
+	{
+		auto const layers = nonempty_layers();
+		auto const visit = [&](int layer) {
+			int const idx = object_at_frame(pos, layer);
+			return idx < 0 || callback(idx, layer);
+		};
+		if (from_bottom) {
+			for (auto it = layers.rbegin(); it != layers.rend(); ++it)
+				if (!visit(*it)) return;
+		}
+		else {
+			for (int layer : layers)
+				if (!visit(layer)) return;
+		}
+	}
+
+	/// @brief `exedit.SortedObject` の連続した区間を参照して，オブジェクトのインデックスを左から順に返すビュー．メモリ確保はしない．
+	/// オブジェクトの並びが変わる操作をすると無効になる．
+	using sorted_object_range = core::sorted_range<ExEdit::Object>;
+
+	/// @brief 指定フレーム区間の間にあるオブジェクトを列挙するビューを返す．
+	/// @param pos_L 区間の左端フレーム位置．
+	/// @param pos_R 区間の右端フレーム位置．
+	/// @param layer 検索対象のレイヤー．
+	/// @param inclusive 区間の端を越えているオブジェクトも含めるかどうか．`true` で含める，`false` で含めない．
+	/// @return 検索結果のオブジェクトのインデックスを左から順に返すビュー．
+	sorted_object_range objects_in_interval_view(int pos_L, int pos_R, int layer, bool inclusive);
+
 	/// @brief 指定フレーム区間の間にあるオブジェクトを列挙する．
 	/// @param pos_L 区間の左端フレーム位置．
 	/// @param pos_R 区間の右端フレーム位置．
 	/// @param layer 検索対象のレイヤー．
 	/// @param inclusive 区間の端を越えているオブジェクトも含めるかどうか．`true` で含める，`false` で含めない．
 	/// @return 検索結果のオブジェクトのインデックスのリスト．順序は左から．
-	std::vector<size_t> objects_in_interval(int pos_L, int pos_R, int layer, bool inclusive);
+	inline std::vector<size_t> objects_in_interval(int pos_L, int pos_R, int layer, bool inclusive)
+	{
+		auto const range = objects_in_interval_view(pos_L, pos_R, layer, inclusive);
+		std::vector<size_t> ret{};
+		ret.reserve(range.size());
+		for (size_t idx : range) ret.push_back(idx);
+		return ret;
+	}
+
+	/// @brief 複数レイヤーにわたって，指定フレーム区間の間にあるオブジェクトを列挙する．メモリ確保はしない．
+	/// @param pos_L 区間の左端フレーム位置．
+	/// @param pos_R 区間の右端フレーム位置．
+	/// @param layer_top 検索対象の最初のレイヤー．
+	/// @param layer_bottom 検索対象の最後のレイヤー．
+	/// @param inclusive 区間の端を越えているオブジェクトも含めるかどうか．`true` で含める，`false` で含めない．
+	/// @param callback オブジェクトのインデックスとレイヤーを受け取る関数．レイヤーごとに左から順に呼ばれる．
+	inline void objects_in_interval(int pos_L, int pos_R, int layer_top, int layer_bottom, bool inclusive,
+		std::invocable<size_t, int> auto&& callback)
+	{
+		for (int layer = layer_top; layer <= layer_bottom; layer++) {
+			for (size_t idx : objects_in_interval_view(pos_L, pos_R, layer, inclusive))
+				callback(idx, layer);
+		}
+	}
 
 	/// @brief whether the object is active (not inactivated).
 	bool is_active(ExEdit::Object const* obj);
@@ -121,35 +202,6 @@ namespace enhanced_tl::timeline
 	/// @brief the size of the right side margin of the timeline, measured in the scrollbar scale, at the current timeline scale.
 	int horiz_scroll_margin();
 
-	namespace constants
-	{
-		constexpr int
-			top_zoom_gauge = 22,
-			width_layer_area = 64, top_layer_area = 42,
-			scrollbar_thick = 13,
-			num_layers = 100, num_scenes = 50,
-			num_zoom_levels = 27;
-	}
-
-	/// @ brief represents the different areas within a timeline user interface.
-	enum class timeline_area : uint8_t {
-		object,		// over (maybe near) an object.
-		blank,			// timeline area where there's no objects.
-		ruler,			// the ruler above the timeline.
-		layer,			// the layer area on the left side of the timeline.
-		zoom_gauge,		// the zoom gauge above the layer area.
-		scene_button,	// the scene button on the top-left.
-		scrollbar_h,	// the horizontal scrollbar on the top of the timeline.
-		scrollbar_v,	// the vertical scrollbar on the right of the timeline.
-	};
-
-	/// @brief Specifies the mode for object detection in `area_from_point()`.
-	enum class area_obj_detection {
-		no,		// skips detecting objects.
-		exact,	// detect objects exactly at the point.
-		nearby,	// detect objects near to the point.
-	};
-
 	/// @brief Determines the timeline area at a given point.
 	/// @param x The client x-coordinate of the point.
 	/// @param y The client y-coordinate of the point.
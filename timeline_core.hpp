@@ -0,0 +1,532 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <span>
+#include <tuple>
+
+#include "timeline_index_core.hpp"
+
+
+////////////////////////////////
+// タイムライン操作 (拡張編集に依存しない部分)．
+////////////////////////////////
+namespace enhanced_tl::timeline
+{
+	/// @ brief represents the different areas within a timeline user interface.
+	enum class timeline_area : uint8_t {
+		object,		// over (maybe near) an object.
+		blank,			// timeline area where there's no objects.
+		ruler,			// the ruler above the timeline.
+		layer,			// the layer area on the left side of the timeline.
+		zoom_gauge,		// the zoom gauge above the layer area.
+		scene_button,	// the scene button on the top-left.
+		scrollbar_h,	// the horizontal scrollbar on the top of the timeline.
+		scrollbar_v,	// the vertical scrollbar on the right of the timeline.
+	};
+
+	/// @brief Specifies the mode for object detection in `area_from_point()`.
+	enum class area_obj_detection {
+		no,		// skips detecting objects.
+		exact,	// detect objects exactly at the point.
+		nearby,	// detect objects near to the point.
+	};
+}
+
+namespace enhanced_tl::timeline::core
+{
+	/// @brief 座標変換が参照するタイムラインの表示状態．
+	template<class V>
+	concept view_state = requires(V const& v, int x, int y) {
+		{ v.zoom_len() } -> std::convertible_to<int>;		// `*exedit.curr_timeline_zoom_len`.
+		{ v.h_scroll() } -> std::convertible_to<int>;		// `*exedit.timeline_h_scroll_pos`.
+		{ v.v_scroll() } -> std::convertible_to<int>;		// `*exedit.timeline_v_scroll_pos`.
+		{ v.layer_height() } -> std::convertible_to<int>;	// `*exedit.curr_timeline_layer_height`.
+		{ v.timeline_width() } -> std::convertible_to<int>;	// `exedit.timeline_size_in_pixels->cx`.
+		{ v.obj_from_point(x, y) } -> std::convertible_to<int>;	// `exedit.obj_from_point`.
+	};
+
+	/// @brief ソート済みの表の連続した区間を参照して，オブジェクトのインデックスを左から順に返すビュー．メモリ確保はしない．
+	/// オブジェクトの並びが変わる操作をすると無効になる．
+	template<class Obj>
+	struct sorted_range {
+		Obj* const* first;
+		Obj* const* last;
+		Obj const* objects; // the head of the object array.
+
+		struct iterator {
+			Obj* const* ptr;
+			Obj const* objects;
+
+			using value_type = size_t;
+			using difference_type = ptrdiff_t;
+			size_t operator*() const { return *ptr - objects; }
+			iterator& operator++() { ++ptr; return *this; }
+			iterator operator++(int) { auto ret = *this; ++ptr; return ret; }
+			bool operator==(iterator const& other) const { return ptr == other.ptr; }
+		};
+		iterator begin() const { return { first, objects }; }
+		iterator end() const { return { last, objects }; }
+		size_t size() const { return last - first; }
+		bool empty() const { return first == last; }
+	};
+
+	namespace detail
+	{
+		// division that rounds toward negative infinity.
+		// `divisor` is assumed to be positive.
+		template<std::integral IntT>
+		constexpr IntT floor_div(IntT dividend, std::integral auto divisor) {
+			if constexpr (std::signed_integral<IntT>)
+				dividend = dividend < 0 ? dividend - static_cast<IntT>(divisor - 1) : dividend;
+			return dividend / static_cast<IntT>(divisor);
+		}
+
+		// タイムラインズームサイズの分母．
+		constexpr int scale_denom = 10'000; // *(double*)(exedit_h + 0x9a548)
+
+		// タイムラインスクロールバーの尺度をズームサイズから計算する係数．
+		constexpr int scroll_step_numerator = 1'000'000,
+			scroll_margin_numerator = 960'000;
+
+// 索引を使った検索は，デバッグビルドでは索引を使わない検索と結果を照合する．
+#define VerifyIndexed(indexed, direct)	assert((indexed) == (direct))
+
+		// `find_nearest_index()` の索引を使わない版．オブジェクトを直接参照して２分法．
+		template<scene_state State>
+		int find_nearest_index_direct(State const& s, int pos, int idx_L, int idx_R)
+		{
+			auto const* const sorted = s.sorted_objects();
+
+			// まず両端のオブジェクトを見る．
+			if (sorted[idx_L]->frame_begin > pos) return idx_L - 1;
+			if (sorted[idx_R]->frame_begin <= pos) idx_L = idx_R;
+
+			// あとは２分法．
+			while (idx_L + 1 < idx_R) {
+				auto const idx = (idx_L + idx_R) >> 1;
+				if (sorted[idx]->frame_begin <= pos) idx_L = idx; else idx_R = idx;
+			}
+			return idx_L;
+		}
+
+		// returns the index of the right-most object whose beginning point is at `pos` or less,
+		// `idx_L-1` if couldn't find such.
+		template<scene_state State>
+		int find_nearest_index(State const& s, int pos, int idx_L, int idx_R)
+		{
+			if (idx_L > idx_R) return idx_L - 1; // 空レイヤー．
+
+			// 開始フレームの配列が使えるなら，分岐のない２分法で探す．
+			if (auto const* const begins = s.index().sorted_frame_begins(s)) {
+				auto const* base = begins + idx_L;
+				for (int n = idx_R - idx_L + 1; n > 1; ) {
+					int const half = n >> 1;
+					base = base[half] <= pos ? base + half : base;
+					n -= half;
+				}
+				int const ret = static_cast<int>(base - begins) - (*base <= pos ? 0 : 1);
+				VerifyIndexed(ret, find_nearest_index_direct(s, pos, idx_L, idx_R));
+				return ret;
+			}
+			return find_nearest_index_direct(s, pos, idx_L, idx_R);
+		}
+
+		// idx 以下で最も近い有効オブジェクトの終了点を線形に検索．
+		template<scene_state State>
+		int find_prev_active_end_direct(State const& s, int idx, int idx_L)
+		{
+			for (; idx_L <= idx; idx--) {
+				if (auto const obj = s.sorted_objects()[idx]; is_active(s, obj))
+					return obj->frame_end + 1;
+			}
+			return 0;
+		}
+
+		// idx 以上で最も近い有効オブジェクトの開始点を線形に検索．
+		template<scene_state State>
+		int find_next_active_begin_direct(State const& s, int idx, int idx_R)
+		{
+			for (; idx <= idx_R; idx++) {
+				if (auto const obj = s.sorted_objects()[idx]; is_active(s, obj))
+					return obj->frame_begin;
+			}
+			return -1;
+		}
+
+		// 中間点の繋がりの末尾を，リストを辿って探す．
+		template<scene_state State>
+		int chain_tail_direct(State const& s, int idx)
+		{
+			for (int j; j = s.next_object(idx), j >= 0; ) idx = j;
+			return idx;
+		}
+	}
+
+	/// @brief returns the final frame of the chain of objects. the next object would start one frame after this.
+	template<scene_state State>
+	int chain_end(State const& s, typename State::object const* obj)
+	{
+		if (auto i = obj->index_midpt_leader; i >= 0) {
+			auto const* const objects = s.object_array();
+			if (auto const chain = s.index().chain_of(s, static_cast<int>(obj - objects))) {
+				VerifyIndexed(chain->tail, detail::chain_tail_direct(s, i));
+				i = chain->tail;
+			}
+			else i = detail::chain_tail_direct(s, i);
+			obj = &objects[i];
+		}
+		return obj->frame_end;
+	}
+
+	namespace detail
+	{
+#define ToSkip(obj)		(skip_inactives && !is_active(s, obj))
+#define ChainBegin(obj)	(skip_midpoints ? chain_begin(s, obj) : (obj)->frame_begin)
+#define ChainEnd(obj)	(skip_midpoints ? chain_end(s, obj) : (obj)->frame_end)
+
+		// idx 以下のオブジェクトの境界や中間点で，条件に当てはまる pos 以下の点を検索．
+		template<scene_state State>
+		int find_adjacent_left_core(State const& s, int idx, int idx_L, int pos, bool skip_midpoints, bool skip_inactives)
+		{
+			if (auto const obj = s.sorted_objects()[idx]; !ToSkip(obj))
+				return pos < obj->frame_end + 1 ? ChainBegin(obj) : ChainEnd(obj) + 1;
+
+			// 無効でない最も近いオブジェクトを探す．索引が使えない場合は線形探索．
+			// 初期 idx が無効オブジェクトでスキップされたという前提があるため，
+			// 最初に見つかった有効オブジェクトの終了点は中間点でなくオブジェクト境界になる．
+			// なので skip_midpoints の確認や ChainEnd() 呼び出しは必要ない．
+			if (idx <= idx_L) return 0;
+			if (auto const i = s.index().prev_active_sorted_index(s, idx - 1)) {
+				int const ret = *i < 0 ? 0 : s.sorted_objects()[*i]->frame_end + 1;
+				VerifyIndexed(ret, find_prev_active_end_direct(s, idx - 1, idx_L));
+				return ret;
+			}
+			return find_prev_active_end_direct(s, idx - 1, idx_L);
+		}
+
+		// idx 以上のオブジェクトの境界や中間点で，条件に当てはまる pos 以上の点を検索．
+		template<scene_state State>
+		int find_adjacent_right_core(State const& s, int idx, int idx_R, int pos, bool skip_midpoints, bool skip_inactives)
+		{
+			// 上の関数の左右逆．
+			if (auto const obj = s.sorted_objects()[idx]; !ToSkip(obj))
+				return pos <= obj->frame_begin ? obj->frame_begin : ChainEnd(obj) + 1;
+
+			if (idx >= idx_R) return -1;
+			if (auto const i = s.index().next_active_sorted_index(s, idx + 1)) {
+				int const ret = *i < 0 ? -1 : s.sorted_objects()[*i]->frame_begin;
+				VerifyIndexed(ret, find_next_active_begin_direct(s, idx + 1, idx_R));
+				return ret;
+			}
+			return find_next_active_begin_direct(s, idx + 1, idx_R);
+		}
+
+#undef ToSkip
+#undef ChainBegin
+#undef ChainEnd
+	}
+
+	/// @brief `timeline::find_left_sorted_index()` の本体．
+	template<scene_state State>
+	int find_left_sorted_index(State const& s, int pos, int layer)
+	{
+		// 指定された位置か，そこより左にある最も近いオブジェクトの index を探す．
+		int const
+			idx_L = s.layer_begin(layer),
+			idx_R = s.layer_end(layer);
+		// pos か，そこより左側に開始点のあるオブジェクトの index を取得．
+		int const idx = detail::find_nearest_index(s, pos, idx_L, idx_R);
+		if (idx < idx_L) return -1; // 空レイヤー or 左側に何もない．
+		return idx;
+	}
+
+	/// @brief `timeline::find_adjacent_left()` の本体．
+	template<scene_state State>
+	int find_adjacent_left(State const& s, int pos, int layer, bool skip_midpoints, bool skip_inactives)
+	{
+		// 指定された位置より左にある最も近い境界を探す．
+		int const
+			idx_L = s.layer_begin(layer),
+			idx_R = s.layer_end(layer);
+
+		// pos より左側に開始点のあるオブジェクトの index を取得．
+		int const idx = detail::find_nearest_index(s, pos - 1, idx_L, idx_R);
+		if (idx < idx_L) return 0; // 空レイヤー or 左側に何もない．
+
+		// そこを起点に線形探索してスキップ対象を除外．
+		return detail::find_adjacent_left_core(s, idx, idx_L, pos - 1, skip_midpoints, skip_inactives);
+	}
+
+	/// @brief `timeline::find_adjacent_right()` の本体．`-1` の場合は最右端．
+	template<scene_state State>
+	int find_adjacent_right(State const& s, int pos, int layer, bool skip_midpoints, bool skip_inactives)
+	{
+		// 上の関数の左右逆版．
+		int const
+			idx_L = s.layer_begin(layer),
+			idx_R = s.layer_end(layer);
+
+		// pos の位置かそれより左側に開始点のあるオブジェクトを取得．
+		int idx = detail::find_nearest_index(s, pos, idx_L, idx_R);
+
+		// pos より右側に終了点のあるオブジェクトの index に修正．
+		if (idx < idx_L) idx = idx_L;
+		else if (s.sorted_objects()[idx]->frame_end + 1 <= pos) idx++;
+		if (idx > idx_R) return -1; // 最右端．
+
+		// そこを起点に線形探索してスキップ対象を除外．
+		return detail::find_adjacent_right_core(s, idx, idx_R, pos + 1, skip_midpoints, skip_inactives);
+	}
+
+	namespace detail
+	{
+		// 全レイヤーの境界検索の索引を使わない版．レイヤーごとに検索する．
+		// 検索対象のレイヤー．空のレイヤーは結果に影響しないので除く．
+		template<scene_state State>
+		index::layer_mask scene_search_layers(State const& s, bool skip_hidden_layers)
+		{
+			auto const& states = s.index().current_layer_states(s);
+			return skip_hidden_layers ? states.nonempty & states.visible : states.nonempty;
+		}
+		template<scene_state State>
+		int find_adjacent_left_scene_direct(State const& s, int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+		{
+			int ret = 0;
+			for (int layer : scene_search_layers(s, skip_hidden_layers))
+				ret = std::max(ret, core::find_adjacent_left(s, pos, layer, skip_midpoints, skip_inactives));
+			return ret;
+		}
+		template<scene_state State>
+		int find_adjacent_right_scene_direct(State const& s, int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers, int len)
+		{
+			int ret = len - 1;
+			for (int layer : scene_search_layers(s, skip_hidden_layers)) {
+				int const pos_r = core::find_adjacent_right(s, pos, layer, skip_midpoints, skip_inactives);
+				ret = std::min(ret, 0 <= pos_r && pos_r < len ? pos_r : len - 1);
+			}
+			return ret;
+		}
+	}
+
+	/// @brief `timeline::find_adjacent_left_scene()` の本体．
+	template<scene_state State>
+	int find_adjacent_left_scene(State const& s, int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+	{
+		// 索引が使えるならそれで検索．使えない場合はレイヤーごとに検索．
+		if (auto const ret = s.index().scene_adjacent_left(s, pos, skip_midpoints, skip_inactives, skip_hidden_layers)) {
+			VerifyIndexed(*ret, detail::find_adjacent_left_scene_direct(s, pos, skip_midpoints, skip_inactives, skip_hidden_layers));
+			return *ret;
+		}
+		return detail::find_adjacent_left_scene_direct(s, pos, skip_midpoints, skip_inactives, skip_hidden_layers);
+	}
+
+	/// @brief `timeline::find_adjacent_right_scene()` の本体．
+	template<scene_state State>
+	int find_adjacent_right_scene(State const& s, int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers, int len)
+	{
+		// 上の関数の左右逆版．
+		if (auto const ret = s.index().scene_adjacent_right(s, pos, skip_midpoints, skip_inactives, skip_hidden_layers)) {
+			int const pos_r = 0 <= *ret && *ret < len ? *ret : len - 1;
+			VerifyIndexed(pos_r, detail::find_adjacent_right_scene_direct(s, pos, skip_midpoints, skip_inactives, skip_hidden_layers, len));
+			return pos_r;
+		}
+		return detail::find_adjacent_right_scene_direct(s, pos, skip_midpoints, skip_inactives, skip_hidden_layers, len);
+	}
+
+	/// @brief `timeline::find_interval()` の本体．
+	template<scene_state State>
+	std::tuple<int, int> find_interval(State const& s, int pos, int layer, bool skip_midpoints, bool skip_inactives)
+	{
+		int const
+			idx_L = s.layer_begin(layer),
+			idx_R = s.layer_end(layer);
+
+		// pos の位置かそれより左側に開始点のあるオブジェクトを取得．
+		int idx = detail::find_nearest_index(s, pos, idx_L, idx_R);
+
+		// まずは左端．
+		int const pos_l = idx < idx_L ? 0 :
+			detail::find_adjacent_left_core(s, idx, idx_L, pos, skip_midpoints, skip_inactives);
+
+		// そして右端．
+		// pos より右側に終了点のあるオブジェクトの index に修正．
+		if (idx < idx_L) idx = idx_L;
+		else if (s.sorted_objects()[idx]->frame_end + 1 <= pos) idx++;
+		int const pos_r = idx > idx_R ? -1 :
+			detail::find_adjacent_right_core(s, idx, idx_R, pos + 1, skip_midpoints, skip_inactives);
+
+		return { pos_l, pos_r };
+	}
+
+	/// @brief `timeline::object_at_frame()` の本体．
+	template<scene_state State>
+	int object_at_frame(State const& s, int pos, int layer)
+	{
+		int const
+			idx_L = s.layer_begin(layer),
+			idx_R = s.layer_end(layer);
+
+		// 候補オブジェクトを特定．
+		int const idx = detail::find_nearest_index(s, pos, idx_L, idx_R);
+		if (idx < idx_L) return -1; // no match.
+
+		auto const* const obj = s.sorted_objects()[idx];
+		if (obj->frame_end < pos) return -1; // pos を含んでいない．
+		return static_cast<int>(obj - s.object_array());
+	}
+
+	/// @brief `timeline::nonempty_layers()` の本体．
+	template<scene_state State>
+	std::span<uint8_t const> nonempty_layers(State const& s)
+	{
+		if (auto const ret = s.index().nonempty_layers(s)) return *ret;
+
+		// 索引が使えない場合は毎回調べる．
+		static constinit std::array<uint8_t, constants::num_layers> layers{};
+		size_t n = 0;
+		for (int layer = 0; layer < constants::num_layers; layer++) {
+			if (s.layer_begin(layer) <= s.layer_end(layer))
+				layers[n++] = static_cast<uint8_t>(layer);
+		}
+		return { layers.data(), n };
+	}
+
+	/// @brief `timeline::objects_in_interval_view()` の本体．
+	template<scene_state State>
+	auto objects_in_interval_view(State const& s, int pos_L, int pos_R, int layer, bool inclusive)
+	{
+		int const
+			idx_L = s.layer_begin(layer),
+			idx_R = s.layer_end(layer);
+		auto* const sorted = s.sorted_objects();
+		auto const* const objects = s.object_array();
+		auto const empty_range = sorted_range<typename State::object>{ sorted, sorted, objects };
+
+		// 左端のオブジェクトを特定．
+		int idx_l = detail::find_nearest_index(s, pos_L, idx_L, idx_R);
+		if (idx_l < idx_L) idx_l = idx_L; // 左側に何もない場合は先頭から．
+		else if (auto const* const obj = sorted[idx_l];
+			(inclusive ? obj->frame_end : obj->frame_begin) < pos_L)
+			// pos_L より左側のオブジェクトは除外．
+			idx_l++;
+		if (idx_l > idx_R) return empty_range; // 空レイヤー or no more objects.
+
+		// 右端のオブジェクトを特定．
+		int idx_r = detail::find_nearest_index(s, pos_R, idx_L, idx_R);
+		if (idx_r < idx_L) return empty_range; // pos_R より左に何もない．
+		if (auto const* const obj = sorted[idx_r];
+			!inclusive && obj->frame_end >= pos_R)
+			// pos_R より右側にはみ出したオブジェクトは除外．
+			idx_r--;
+
+		if (idx_l > idx_r) return empty_range; // no matches.
+
+		return sorted_range<typename State::object>{ sorted + idx_l, sorted + idx_r + 1, objects };
+	}
+
+	// 座標変換．
+	/// @brief `timeline::point_to_frame()` の本体．
+	template<view_state View>
+	int point_to_frame(View const& v, int x)
+	{
+		x -= constants::width_layer_area;
+		x *= detail::scale_denom;
+		x = detail::floor_div(x, std::max(v.zoom_len(), 1));
+		x += v.h_scroll();
+		if (x < 0) x = 0;
+
+		return x;
+	}
+
+	/// @brief `timeline::point_from_frame()` の本体．
+	template<view_state View>
+	int point_from_frame(View const& v, int f)
+	{
+		f -= v.h_scroll();
+		{
+			// possibly overflow; curr_timeline_zoom_len is at most 100'000 (> 2^16).
+			int64_t F = f;
+			F *= v.zoom_len();
+			F = detail::floor_div(F, detail::scale_denom);
+			f = static_cast<int32_t>(F);
+		}
+		f += constants::width_layer_area;
+
+		return f;
+	}
+
+	/// @brief `timeline::point_to_layer()` の本体．
+	template<view_state View>
+	int point_to_layer(View const& v, int y)
+	{
+		y -= constants::top_layer_area;
+		y = detail::floor_div(y, std::max(v.layer_height(), 1));
+		y += v.v_scroll();
+		y = std::clamp(y, 0, constants::num_layers - 1);
+
+		return y;
+	}
+
+	/// @brief `timeline::point_from_layer()` の本体．
+	template<view_state View>
+	int point_from_layer(View const& v, int l)
+	{
+		l -= v.v_scroll();
+		l *= v.layer_height();
+		l += constants::top_layer_area;
+
+		return l;
+	}
+
+	/// @brief `timeline::area_from_point()` の本体．
+	template<class State> requires scene_state<State> && view_state<State>
+	timeline_area area_from_point(State const& s, int x, int y, area_obj_detection mode)
+	{
+		using enum timeline_area;
+		namespace cs = constants;
+		if (x < cs::width_layer_area) {
+			if (y < cs::top_zoom_gauge)
+				return scene_button;
+			if (y < cs::top_layer_area)
+				return zoom_gauge;
+			return layer;
+		}
+		if (y < cs::scrollbar_thick)
+			return scrollbar_h;
+		if (x < s.timeline_width() - cs::scrollbar_thick) {
+			if (y < cs::top_layer_area)
+				return ruler;
+			switch (mode) {
+			default:
+			case area_obj_detection::no:
+				return blank;
+			case area_obj_detection::exact:
+				return object_at_frame(s, point_to_frame(s, x), point_to_layer(s, y)) < 0 ?
+					blank : object;
+			case area_obj_detection::nearby:
+				return s.obj_from_point(x, y) < 0 ?
+					blank : object;
+			}
+		}
+		return scrollbar_v;
+	}
+
+#undef VerifyIndexed
+}
@@ -0,0 +1,139 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+using byte = uint8_t;
+#include <exedit.hpp>
+
+#include "enhanced_tl.hpp"
+#include "timeline.hpp"
+#include "timeline_index.hpp"
+
+
+#define NS_BEGIN(...) namespace __VA_ARGS__ {
+#define NS_END }
+NS_BEGIN()
+
+////////////////////////////////
+// タイムライン検索の索引．
+////////////////////////////////
+using enhanced_tl::timeline::index::exedit_state;
+
+// incremented by `invalidate()` to distinguish states within the same undo step.
+static constinit uint32_t edit_serial = 0;
+
+// 拡張編集のシーンに対する索引一式．
+#ifdef NDEBUG
+constinit
+#endif
+static enhanced_tl::timeline::core::search_index<exedit_state> exedit_index{};
+NS_END
+
+
+////////////////////////////////
+// exported functions.
+////////////////////////////////
+namespace expt = enhanced_tl::timeline::index;
+
+expt::generation expt::exedit_state::current_generation() const
+{
+	return { *exedit.undo_id_ptr, *exedit.current_scene, *exedit.ObjectArray_ptr, edit_serial };
+}
+
+bool expt::exedit_state::frames_settled() const
+{
+	switch (*exedit.timeline_drag_kind) {
+	case drag_kind::move_object:
+	case drag_kind::move_object_left:
+	case drag_kind::move_object_right:
+		return false;
+	default:
+		return true;
+	}
+}
+
+enhanced_tl::timeline::core::search_index<exedit_state>& expt::exedit_state::index() const
+{
+	return exedit_index;
+}
+
+expt::layer_states const& expt::current_layer_states()
+{
+	return exedit_index.current_layer_states({});
+}
+
+void expt::invalidate()
+{
+	edit_serial++;
+}
+
+bool expt::frames_settled()
+{
+	return exedit_state{}.frames_settled();
+}
+
+std::optional<int> expt::scene_adjacent_left(int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+{
+	return exedit_index.scene_adjacent_left({}, pos, skip_midpoints, skip_inactives, skip_hidden_layers);
+}
+
+std::optional<int> expt::scene_adjacent_right(int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+{
+	return exedit_index.scene_adjacent_right({}, pos, skip_midpoints, skip_inactives, skip_hidden_layers);
+}
+
+std::optional<int> expt::prev_active_sorted_index(int idx)
+{
+	return exedit_index.prev_active_sorted_index({}, idx);
+}
+
+std::optional<int> expt::next_active_sorted_index(int idx)
+{
+	return exedit_index.next_active_sorted_index({}, idx);
+}
+
+std::optional<expt::chain_info> expt::chain_of(int idx_object)
+{
+	return exedit_index.chain_of({}, idx_object);
+}
+
+int32_t const* expt::sorted_frame_begins()
+{
+	return exedit_index.sorted_frame_begins({});
+}
+
+std::optional<std::span<expt::free_interval const>> expt::gaps_of_layer(int layer)
+{
+	return exedit_index.gaps_of_layer({}, layer);
+}
+
+std::optional<expt::free_interval> expt::largest_gap(int layer)
+{
+	return exedit_index.largest_gap({}, layer);
+}
+
+std::optional<expt::free_interval> expt::find_gap(int layer, int frame, int len)
+{
+	return exedit_index.find_gap({}, layer, frame, len);
+}
+
+std::optional<std::span<uint8_t const>> expt::nonempty_layers()
+{
+	return exedit_index.nonempty_layers({});
+}
@@ -0,0 +1,141 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+using byte = uint8_t;
+#include <exedit.hpp>
+
+#include "enhanced_tl.hpp"
+#include "timeline_index_core.hpp"
+
+
+////////////////////////////////
+// タイムライン検索の索引．
+////////////////////////////////
+namespace enhanced_tl::timeline::index
+{
+	/// @brief 拡張編集の変数を直接読む，タイムライン検索の対象となるシーンの状態．
+	struct exedit_state {
+		using object = ExEdit::Object;
+
+		ExEdit::Object* const* sorted_objects() const { return exedit.SortedObject; }
+		ExEdit::Object const* object_array() const { return *exedit.ObjectArray_ptr; }
+		int layer_begin(int layer) const { return exedit.SortedObjectLayerBeginIndex[layer]; }
+		int layer_end(int layer) const { return exedit.SortedObjectLayerEndIndex[layer]; }
+		int next_object(int idx) const { return exedit.NextObjectIdxArray[idx]; }
+
+		bool active_flag(ExEdit::Object const* obj) const {
+			return has_flag_or(obj->filter_status[0], ExEdit::Object::FilterStatus::Active);
+		}
+		bool layer_visible(int layer) const {
+			return !has_flag_or(layer_setting(layer).flag, ExEdit::LayerSetting::Flag::UnDisp);
+		}
+		bool layer_locked(int layer) const {
+			return has_flag_or(layer_setting(layer).flag, ExEdit::LayerSetting::Flag::Locked);
+		}
+
+		int zoom_len() const { return *exedit.curr_timeline_zoom_len; }
+		int h_scroll() const { return *exedit.timeline_h_scroll_pos; }
+		int v_scroll() const { return *exedit.timeline_v_scroll_pos; }
+		int layer_height() const { return *exedit.curr_timeline_layer_height; }
+		int timeline_width() const { return exedit.timeline_size_in_pixels->cx; }
+		int obj_from_point(int x, int y) const { return exedit.obj_from_point(x, y); }
+
+		generation current_generation() const;
+		bool frames_settled() const;
+		core::search_index<exedit_state>& index() const;
+
+	private:
+		static ExEdit::LayerSetting const& layer_setting(int layer) {
+			return exedit.LayerSettings[*exedit.current_scene * constants::num_layers + layer];
+		}
+	};
+
+	/// @brief 現在のシーンのレイヤーの状態を取得する．
+	/// undo の状態やシーンが変わるまで使い回し，オブジェクトのドラッグ中は毎回作り直す．
+	/// @return レイヤーの状態．次に呼び出すまで有効．
+	layer_states const& current_layer_states();
+
+	/// @brief discards all indices built so far.
+	/// call this after modifying objects without pushing a new undo step.
+	void invalidate();
+
+	/// @brief whether the frame positions of objects are settled.
+	/// they are not while exedit is dragging objects, as it doesn't push undo steps on each move.
+	bool frames_settled();
+
+	/// @brief searches the entire scene for the nearest boundary on the left, using the index.
+	/// @param pos 指定位置，フレーム単位．
+	/// @param skip_midpoints 中間点を無視するかどうか．
+	/// @param skip_inactives 無効オブジェクトを無視するかどうか．
+	/// @param skip_hidden_layers 非表示レイヤーを無視するかどうか．
+	/// @return 検索結果のフレーム位置．索引が利用できない場合は `std::nullopt`.
+	std::optional<int> scene_adjacent_left(int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers);
+
+	/// @brief searches the entire scene for the nearest boundary on the right, using the index.
+	/// @param pos 指定位置，フレーム単位．
+	/// @param skip_midpoints 中間点を無視するかどうか．
+	/// @param skip_inactives 無効オブジェクトを無視するかどうか．
+	/// @param skip_hidden_layers 非表示レイヤーを無視するかどうか．
+	/// @return 検索結果のフレーム位置．`-1` の場合は最右端．索引が利用できない場合は `std::nullopt`.
+	std::optional<int> scene_adjacent_right(int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers);
+
+	/// @brief 同じレイヤー内で，`exedit.SortedObject` での位置が `idx` 以下の最も近い有効オブジェクトを探す．
+	/// @param idx `exedit.SortedObject` での位置．
+	/// @return 検索結果の `exedit.SortedObject` での位置．存在しない場合は `-1`．索引が利用できない場合は `std::nullopt`.
+	std::optional<int> prev_active_sorted_index(int idx);
+
+	/// @brief 同じレイヤー内で，`exedit.SortedObject` での位置が `idx` 以上の最も近い有効オブジェクトを探す．
+	/// @param idx `exedit.SortedObject` での位置．
+	/// @return 検索結果の `exedit.SortedObject` での位置．存在しない場合は `-1`．索引が利用できない場合は `std::nullopt`.
+	std::optional<int> next_active_sorted_index(int idx);
+
+	/// @brief オブジェクトのあるレイヤーを上から順に並べたものを取得する．
+	/// @return レイヤーの列．次に編集されるまで有効．索引が利用できない場合は `std::nullopt`.
+	std::optional<std::span<uint8_t const>> nonempty_layers();
+
+	/// @brief `exedit.SortedObject` と同じ並びで，各オブジェクトの開始フレームを詰めた配列を取得する．
+	/// @return 配列の先頭．索引が利用できない場合は `nullptr`.
+	int32_t const* sorted_frame_begins();
+
+	/// @brief 指定オブジェクトを含む中間点の繋がりの構造を取得する．オブジェクトのドラッグ中でも利用できる．
+	/// @param idx_object オブジェクトのインデックス．
+	/// @return 検索結果．現在のシーンにないオブジェクトや，索引が利用できない場合は `std::nullopt`.
+	std::optional<chain_info> chain_of(int idx_object);
+
+	/// @brief 指定レイヤーの空き区間を左から順に並べたものを取得する．
+	/// `k` 番目の要素はレイヤー内で `k` 番目のオブジェクトの直前の区間で，長さ 0 のものも含む．最後の要素は最右端までの区間．
+	/// @param layer 検索対象のレイヤー．
+	/// @return 空き区間の列．次に編集されるまで有効．索引が利用できない場合は `std::nullopt`.
+	std::optional<std::span<free_interval const>> gaps_of_layer(int layer);
+
+	/// @brief 指定レイヤーのオブジェクトに挟まれた空き区間のうち，最も長いものを探す．
+	/// @param layer 検索対象のレイヤー．
+	/// @return 検索結果の区間．そのような区間がない場合は長さ 0 の区間．索引が利用できない場合は `std::nullopt`.
+	std::optional<free_interval> largest_gap(int layer);
+
+	/// @brief 指定レイヤーで，指定フレーム以降に始まる長さ `len` 以上の空き区間を探す．
+	/// @param layer 検索対象のレイヤー．
+	/// @param frame 検索開始位置，フレーム単位．
+	/// @param len 必要な長さ，フレーム単位．
+	/// @return 見つかった区間．`frame` を含む区間の場合は `frame` から始まるように切り詰める．最右端までの区間があるので必ず見つかる．索引が利用できない場合は `std::nullopt`.
+	std::optional<free_interval> find_gap(int layer, int frame, int len);
+}
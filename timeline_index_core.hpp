@@ -0,0 +1,568 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2025 sigma-axis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+////////////////////////////////
+// タイムライン検索の索引 (拡張編集に依存しない部分)．
+////////////////////////////////
+namespace enhanced_tl::timeline::constants
+{
+	constexpr int
+		top_zoom_gauge = 22,
+		width_layer_area = 64, top_layer_area = 42,
+		scrollbar_thick = 13,
+		num_layers = 100, num_scenes = 50,
+		num_zoom_levels = 27;
+}
+
+namespace enhanced_tl::timeline::index
+{
+	/// @brief identifies a state of the object tables of the current scene.
+	/// indices built from the tables are valid as long as this value doesn't change.
+	struct generation {
+		uint32_t undo_id;
+		int32_t scene;
+		void const* objects;
+		uint32_t serial;
+
+		constexpr bool operator==(generation const&) const = default;
+	};
+
+	/// @brief レイヤーの集合．レイヤーごとに 1 ビットで，立っているビットだけを上から順に辿れる．
+	struct layer_mask {
+		uint64_t lo, hi; // layers 0--63 and 64--127.
+
+		constexpr bool test(int layer) const { return (((layer < 64 ? lo : hi) >> (layer & 63)) & 1) != 0; }
+		constexpr void set(int layer) { (layer < 64 ? lo : hi) |= uint64_t{ 1 } << (layer & 63); }
+		constexpr bool empty() const { return (lo | hi) == 0; }
+		constexpr int count() const { return std::popcount(lo) + std::popcount(hi); }
+
+		constexpr layer_mask operator&(layer_mask const& other) const { return { lo & other.lo, hi & other.hi }; }
+		constexpr layer_mask operator|(layer_mask const& other) const { return { lo | other.lo, hi | other.hi }; }
+		/// @brief the complement within the valid layers.
+		constexpr layer_mask operator~() const { return layer_mask{ ~lo, ~hi } & all(); }
+		constexpr bool operator==(layer_mask const&) const = default;
+
+		/// @brief the set of all the valid layers.
+		static constexpr layer_mask all()
+		{
+			constexpr int n = constants::num_layers;
+			return { ~uint64_t{ 0 }, (uint64_t{ 1 } << (n - 64)) - 1 };
+		}
+
+		struct iterator {
+			using difference_type = ptrdiff_t;
+			using value_type = int;
+			uint64_t lo, hi;
+
+			constexpr int operator*() const { return lo != 0 ? std::countr_zero(lo) : 64 + std::countr_zero(hi); }
+			constexpr iterator& operator++() { if (lo != 0) lo &= lo - 1; else hi &= hi - 1; return *this; }
+			constexpr iterator operator++(int) { auto ret = *this; ++*this; return ret; }
+			constexpr bool operator==(std::default_sentinel_t) const { return (lo | hi) == 0; }
+		};
+		constexpr iterator begin() const { return { lo, hi }; }
+		constexpr std::default_sentinel_t end() const { return {}; }
+	};
+	static_assert(layer_mask::all().count() == constants::num_layers);
+
+	/// @brief 現在のシーンのレイヤーの状態をビット集合で表したもの．
+	struct layer_states {
+		layer_mask visible;		// 表示されているレイヤー．
+		layer_mask locked;		// ロックされているレイヤー．
+		layer_mask nonempty;	// オブジェクトのあるレイヤー．
+	};
+
+	/// @brief 中間点で繋がったオブジェクトの構造．中間点のないオブジェクトは長さ 1 の繋がりとみなす．
+	struct chain_info {
+		int32_t head;	// 先頭オブジェクトのインデックス．
+		int32_t tail;	// 末尾オブジェクトのインデックス．
+		int32_t prev;	// 直前のオブジェクトのインデックス．先頭の場合は `-1`．
+		int32_t pos;	// 繋がりの中での位置，0 始まり．
+		int32_t count;	// 繋がりに含まれるオブジェクトの個数．
+	};
+
+	/// @brief レイヤー上のオブジェクトのない区間．`[begin, end)` の範囲で，`end` が `-1` の場合は最右端まで．
+	struct free_interval {
+		int32_t begin, end;
+	};
+}
+
+namespace enhanced_tl::timeline::core
+{
+	template<class State> class search_index;
+
+	/// @brief タイムライン検索が参照するシーンの状態．拡張編集の変数を直接読むものと，メモリ上のシーンを読むものがある．
+	/// オブジェクトの配列，レイヤーごとに並べたポインタの表，中間点の繋がりの表は拡張編集と同じ形式．
+	/// `object` は `frame_begin`, `frame_end`, `index_midpt_leader` のメンバを持つ型．
+	template<class S>
+	concept scene_state = requires(S const& s, int i, typename S::object const* obj) {
+		{ s.sorted_objects() } -> std::convertible_to<typename S::object* const*>;	// `exedit.SortedObject`.
+		{ s.object_array() } -> std::convertible_to<typename S::object const*>;		// `*exedit.ObjectArray_ptr`.
+		{ s.layer_begin(i) } -> std::convertible_to<int>;	// `exedit.SortedObjectLayerBeginIndex`.
+		{ s.layer_end(i) } -> std::convertible_to<int>;		// `exedit.SortedObjectLayerEndIndex`.
+		{ s.next_object(i) } -> std::convertible_to<int>;	// `exedit.NextObjectIdxArray`.
+		{ s.active_flag(obj) } -> std::same_as<bool>;		// the flag on the object itself, not its chain.
+		{ s.layer_visible(i) } -> std::same_as<bool>;
+		{ s.layer_locked(i) } -> std::same_as<bool>;
+		{ s.current_generation() } -> std::same_as<index::generation>;
+		{ s.frames_settled() } -> std::same_as<bool>;
+		{ s.index() } -> std::same_as<search_index<S>&>;	// the caches for this state.
+	};
+
+	/// @brief whether the object is active, judged by the head of its chain.
+	template<class State>
+	bool is_active(State const& s, typename State::object const* obj)
+	{
+		if (auto i = obj->index_midpt_leader; i >= 0) obj = &s.object_array()[i];
+		return s.active_flag(obj);
+	}
+
+	/// @brief returns the beginning frame of the chain of objects.
+	template<class State>
+	int chain_begin(State const& s, typename State::object const* obj)
+	{
+		if (auto i = obj->index_midpt_leader; i >= 0) obj = &s.object_array()[i];
+		return obj->frame_begin;
+	}
+
+	/// @brief 索引の作り直しが必要かどうかを世代で判定するキャッシュの基底．
+	struct cache_base {
+		index::generation gen{};
+		bool valid = false;
+
+		// checks whether the cache built for `gen` is still usable, calling `build()` if outdated.
+		// caches depending on frames or the sorted order of objects should also check `frames_settled()`.
+		bool prepare(index::generation const& curr, auto&& build)
+		{
+			if (valid && gen == curr) return true;
+
+			build();
+			gen = curr;
+			valid = true;
+			return true;
+		}
+	};
+
+	/// @brief シーンの状態 `State` から作る検索用の索引一式．
+	/// 各索引は最初に使われたときに作り，世代が変わると作り直す．
+	template<class State>
+	class search_index {
+		using layer_mask = index::layer_mask;
+		using free_interval = index::free_interval;
+		static constexpr int num_layers = constants::num_layers;
+
+		// the end of the sorted table, counted over all the layers.
+		static int sorted_len(State const& s)
+		{
+			int len = 0;
+			for (int layer = 0; layer < num_layers; layer++)
+				len = std::max(len, s.layer_end(layer) + 1);
+			return len;
+		}
+
+		// レイヤーの表示・ロック・オブジェクト有無の状態をビット集合にまとめたもの．
+		struct LayerStates : cache_base {
+			index::layer_states states{};
+
+			auto const& get(State const& s)
+			{
+				// the layers of objects may change during drags without undo steps.
+				if (!s.frames_settled()) valid = false;
+				prepare(s.current_generation(), [&] { build(s); });
+				return states;
+			}
+
+		private:
+			void build(State const& s)
+			{
+				states = {};
+				for (int layer = 0; layer < num_layers; layer++) {
+					if (s.layer_visible(layer)) states.visible.set(layer);
+					if (s.layer_locked(layer)) states.locked.set(layer);
+					if (s.layer_begin(layer) <= s.layer_end(layer)) states.nonempty.set(layer);
+				}
+			}
+		} layer_states_cache;
+
+		// シーン全体のオブジェクト境界と中間点を，フレーム位置順に並べた索引．
+		struct SceneBoundaries : cache_base {
+			enum flag : uint8_t {
+				midpt		= 1 << 0, // the point is a mid-point.
+				inactive	= 1 << 1, // the object is inactive.
+			};
+			struct point {
+				int32_t frame;
+				uint8_t layer, flags;
+			};
+			std::vector<point> points{};
+
+			// frames narrowed down by the skip options, combined for all layers.
+			struct view {
+				bool valid = false;
+				layer_mask layers{};
+				std::vector<int32_t> frames{};
+			} views[4]{};
+
+			// returns `nullptr` if the index is unavailable now.
+			view const* get_view(State const& s, layer_mask const& visible,
+				bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+			{
+				if (!s.frames_settled()) return nullptr;
+				prepare(s.current_generation(), [&] {
+					build(s);
+					for (auto& v : views) v.valid = false;
+				});
+
+				layer_mask const layers = skip_hidden_layers ? visible : layer_mask::all();
+				auto& v = views[(skip_midpoints ? 2 : 0) + (skip_inactives ? 1 : 0)];
+				if (v.valid && v.layers == layers) return &v;
+
+				// collect frames that pass the filter.
+				uint8_t const mask = (skip_midpoints ? midpt : 0) | (skip_inactives ? inactive : 0);
+				v.frames.clear();
+				for (auto const& pt : points) {
+					if ((pt.flags & mask) != 0 || !layers.test(pt.layer)) continue;
+					if (v.frames.empty() || v.frames.back() != pt.frame)
+						v.frames.push_back(pt.frame);
+				}
+				v.layers = layers;
+				v.valid = true;
+				return &v;
+			}
+
+		private:
+			void build(State const& s)
+			{
+				points.clear();
+				auto const* const objects = s.object_array();
+				for (int layer = 0; layer < num_layers; layer++) {
+					for (int j = s.layer_begin(layer), R = s.layer_end(layer); j <= R; j++) {
+						auto const* const obj = s.sorted_objects()[j];
+						int const idx = static_cast<int>(obj - objects), idx_leader = obj->index_midpt_leader;
+						uint8_t const flag_active = is_active(s, obj) ? 0 : inactive;
+
+						// the beginning is a mid-point unless it's the head of the chain,
+						// and so is the end unless it's the tail.
+						points.push_back({ obj->frame_begin, static_cast<uint8_t>(layer),
+							static_cast<uint8_t>(flag_active | (idx_leader >= 0 && idx_leader != idx ? midpt : 0)) });
+						points.push_back({ obj->frame_end + 1, static_cast<uint8_t>(layer),
+							static_cast<uint8_t>(flag_active | (idx_leader >= 0 && s.next_object(idx) >= 0 ? midpt : 0)) });
+					}
+				}
+				std::ranges::sort(points, {}, &point::frame);
+			}
+		} scene_boundaries;
+
+		// 各レイヤー内で，ソート済みの表の位置ごとに最も近い有効オブジェクトの位置を記録した表．
+		struct ActiveNeighbors : cache_base {
+			// indices into the sorted table, `-1` if there's no such object in the same layer.
+			std::vector<int32_t> prev{}, next{};
+
+			bool prepare(State const& s)
+			{
+				if (!s.frames_settled()) return false;
+				return cache_base::prepare(s.current_generation(), [&] { build(s); });
+			}
+
+		private:
+			void build(State const& s)
+			{
+				int const len = sorted_len(s);
+				prev.assign(len, -1);
+				next.assign(len, -1);
+
+				for (int layer = 0; layer < num_layers; layer++) {
+					int const
+						idx_L = s.layer_begin(layer),
+						idx_R = s.layer_end(layer);
+					for (int j = idx_L, last = -1; j <= idx_R; j++) {
+						if (is_active(s, s.sorted_objects()[j])) last = j;
+						prev[j] = last;
+					}
+					for (int j = idx_R, last = -1; j >= idx_L; j--) {
+						if (is_active(s, s.sorted_objects()[j])) last = j;
+						next[j] = last;
+					}
+				}
+			}
+		} active_neighbors;
+
+		// オブジェクトのあるレイヤーを上から順に並べたもの．
+		struct NonemptyLayers : cache_base {
+			std::vector<uint8_t> layers{};
+
+			bool prepare(State const& s, layer_mask const& nonempty)
+			{
+				if (!s.frames_settled()) return false;
+				return cache_base::prepare(s.current_generation(), [&] {
+					layers.clear();
+					for (int layer : nonempty)
+						layers.push_back(static_cast<uint8_t>(layer));
+				});
+			}
+		} nonempty_layer_list;
+
+		// ソート済みの表と同じ順にオブジェクトの開始フレームを詰めた配列．
+		// 二分探索でオブジェクトのデータを参照せずに済ませるためのもの．
+		struct SortedFrames : cache_base {
+			std::vector<int32_t> begins{};
+
+			bool prepare(State const& s)
+			{
+				if (!s.frames_settled()) return false;
+				return cache_base::prepare(s.current_generation(), [&] { build(s); });
+			}
+
+		private:
+			void build(State const& s)
+			{
+				begins.assign(sorted_len(s), 0);
+				for (int layer = 0; layer < num_layers; layer++) {
+					for (int j = s.layer_begin(layer), R = s.layer_end(layer); j <= R; j++)
+						begins[j] = s.sorted_objects()[j]->frame_begin;
+				}
+			}
+		} sorted_frames;
+
+		// 中間点で繋がったオブジェクトの構造を，オブジェクトのインデックスごとに記録した表．
+		// フレーム位置は記録しないので，オブジェクトのドラッグ中でも有効．
+		struct ChainTable : cache_base {
+			using chain_info = index::chain_info;
+
+			// indexed by the object index. `head < 0` for objects outside the current scene.
+			std::vector<chain_info> entries{};
+
+			bool prepare(State const& s) { return cache_base::prepare(s.current_generation(), [&] { build(s); }); }
+
+		private:
+			void build(State const& s)
+			{
+				auto const* const objects = s.object_array();
+				int len = 0;
+				for (int layer = 0; layer < num_layers; layer++) {
+					for (int j = s.layer_begin(layer), R = s.layer_end(layer); j <= R; j++)
+						len = std::max<int>(len, static_cast<int>(s.sorted_objects()[j] - objects) + 1);
+				}
+				entries.assign(len, { -1, -1, -1, 0, 0 });
+
+				for (int layer = 0; layer < num_layers; layer++) {
+					for (int j = s.layer_begin(layer), R = s.layer_end(layer); j <= R; j++) {
+						auto const* const obj = s.sorted_objects()[j];
+						int const idx = static_cast<int>(obj - objects), idx_leader = obj->index_midpt_leader;
+						if (idx_leader < 0) entries[idx] = { idx, idx, -1, 0, 1 };
+						else if (idx_leader == idx) {
+							// walk through the chain from its head.
+							int count = 0, tail = idx;
+							for (int i = idx, prev = -1; i >= 0; prev = i, i = s.next_object(i)) {
+								entries[i] = { idx, -1, prev, count++, 0 };
+								tail = i;
+							}
+							for (int i = idx; i >= 0; i = s.next_object(i)) {
+								entries[i].tail = tail;
+								entries[i].count = count;
+							}
+						}
+					}
+				}
+			}
+		} chain_table;
+
+		// 各レイヤーのオブジェクト間の空き区間の表と，その長さの最大値を引くための木．
+		struct LayerGaps : cache_base {
+			// gaps of the layer `L` are `gaps[offsets[L]..offsets[L + 1]]`,
+			// the k-th of which is the interval right before the k-th object, the last one being unbounded.
+			std::vector<free_interval> gaps{};
+			std::array<int32_t, num_layers + 1> offsets{};
+
+			// segment trees for the max length of gaps, one per layer.
+			// the tree for the layer `L` starts at `tree_offsets[L]` and has `2 * leaves[L]` nodes.
+			std::vector<int32_t> trees{};
+			std::array<int32_t, num_layers> tree_offsets{}, leaves{};
+
+			std::array<int32_t, num_layers> idx_largest{}; // `-1` if no bounded gaps.
+
+			bool prepare(State const& s)
+			{
+				if (!s.frames_settled()) return false;
+				return cache_base::prepare(s.current_generation(), [&] { build(s); });
+			}
+
+			std::span<free_interval const> of_layer(int layer) const
+			{
+				return { gaps.data() + offsets[layer], gaps.data() + offsets[layer + 1] };
+			}
+
+			// finds the first gap at `k0` or later whose length is at least `len`. `-1` if none.
+			int first_at_least(int layer, int k0, int32_t len) const
+			{
+				return descend(&trees[tree_offsets[layer]], 1, 0, leaves[layer], k0, len);
+			}
+
+			static constexpr int32_t unbounded = std::numeric_limits<int32_t>::max();
+			static int32_t length(free_interval const& gap) { return gap.end < 0 ? unbounded : gap.end - gap.begin; }
+
+		private:
+			static int descend(int32_t const* tree, int node, int lo, int hi, int k0, int32_t len)
+			{
+				if (hi <= k0 || tree[node] < len) return -1;
+				if (hi - lo == 1) return lo;
+				int const mid = (lo + hi) >> 1;
+				if (int const ret = descend(tree, 2 * node, lo, mid, k0, len); ret >= 0) return ret;
+				return descend(tree, 2 * node + 1, mid, hi, k0, len);
+			}
+
+			void build(State const& s)
+			{
+				gaps.clear(); trees.clear();
+				for (int layer = 0; layer < num_layers; layer++) {
+					offsets[layer] = static_cast<int32_t>(gaps.size());
+					int32_t prev_end = 0, largest = 0;
+					idx_largest[layer] = -1;
+					int const L = s.layer_begin(layer), R = s.layer_end(layer);
+					for (int j = L; j <= R; j++) {
+						auto const* const obj = s.sorted_objects()[j];
+						// the gap before the first object is bounded by the beginning of the scene, not an object.
+						if (j > L && obj->frame_begin - prev_end > largest) {
+							largest = obj->frame_begin - prev_end;
+							idx_largest[layer] = static_cast<int32_t>(gaps.size()) - offsets[layer];
+						}
+						gaps.push_back({ prev_end, obj->frame_begin });
+						prev_end = obj->frame_end + 1;
+					}
+					gaps.push_back({ prev_end, -1 });
+
+					// build the segment tree over the lengths.
+					int const n = static_cast<int>(gaps.size()) - offsets[layer], P = std::bit_ceil(static_cast<uint32_t>(n));
+					tree_offsets[layer] = static_cast<int32_t>(trees.size());
+					leaves[layer] = P;
+					trees.resize(trees.size() + 2 * P, -1);
+					auto* const tree = &trees[tree_offsets[layer]];
+					for (int k = 0; k < n; k++) tree[P + k] = length(gaps[offsets[layer] + k]);
+					for (int node = P - 1; node > 0; node--) tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+				}
+				offsets[num_layers] = static_cast<int32_t>(gaps.size());
+			}
+		} layer_gaps;
+
+	public:
+		constexpr search_index() = default;
+
+		/// @brief レイヤーの状態を取得する．オブジェクトのドラッグ中は毎回作り直す．
+		index::layer_states const& current_layer_states(State const& s) { return layer_states_cache.get(s); }
+
+		/// @brief 全レイヤーから `pos` より左にある最も近い境界を探す．索引が利用できない場合は `std::nullopt`.
+		std::optional<int> scene_adjacent_left(State const& s, int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+		{
+			auto const* const v = scene_boundaries.get_view(s, skip_hidden_layers ? current_layer_states(s).visible : layer_mask{},
+				skip_midpoints, skip_inactives, skip_hidden_layers);
+			if (v == nullptr) return std::nullopt;
+
+			// the right-most frame less than pos.
+			auto const it = std::ranges::lower_bound(v->frames, pos);
+			return it == v->frames.begin() ? 0 : *(it - 1);
+		}
+
+		/// @brief 全レイヤーから `pos` より右にある最も近い境界を探す．`-1` の場合は最右端．索引が利用できない場合は `std::nullopt`.
+		std::optional<int> scene_adjacent_right(State const& s, int pos, bool skip_midpoints, bool skip_inactives, bool skip_hidden_layers)
+		{
+			auto const* const v = scene_boundaries.get_view(s, skip_hidden_layers ? current_layer_states(s).visible : layer_mask{},
+				skip_midpoints, skip_inactives, skip_hidden_layers);
+			if (v == nullptr) return std::nullopt;
+
+			// the left-most frame greater than pos.
+			auto const it = std::ranges::upper_bound(v->frames, pos);
+			return it == v->frames.end() ? -1 : *it;
+		}
+
+		/// @brief 同じレイヤー内で，ソート済みの表での位置が `idx` 以下の最も近い有効オブジェクトの位置．存在しない場合は `-1`.
+		std::optional<int> prev_active_sorted_index(State const& s, int idx)
+		{
+			if (!active_neighbors.prepare(s)) return std::nullopt;
+			return active_neighbors.prev[idx];
+		}
+
+		/// @brief 同じレイヤー内で，ソート済みの表での位置が `idx` 以上の最も近い有効オブジェクトの位置．存在しない場合は `-1`.
+		std::optional<int> next_active_sorted_index(State const& s, int idx)
+		{
+			if (!active_neighbors.prepare(s)) return std::nullopt;
+			return active_neighbors.next[idx];
+		}
+
+		/// @brief 指定オブジェクトを含む中間点の繋がりの構造．
+		std::optional<index::chain_info> chain_of(State const& s, int idx_object)
+		{
+			if (!chain_table.prepare(s) ||
+				idx_object < 0 || idx_object >= static_cast<int>(chain_table.entries.size())) return std::nullopt;
+			auto const& ret = chain_table.entries[idx_object];
+			if (ret.head < 0) return std::nullopt;
+			return ret;
+		}
+
+		/// @brief ソート済みの表と同じ並びの開始フレームの配列．索引が利用できない場合は `nullptr`.
+		int32_t const* sorted_frame_begins(State const& s)
+		{
+			if (!sorted_frames.prepare(s)) return nullptr;
+			return sorted_frames.begins.data();
+		}
+
+		/// @brief 指定レイヤーの空き区間の列．
+		std::optional<std::span<free_interval const>> gaps_of_layer(State const& s, int layer)
+		{
+			if (!layer_gaps.prepare(s)) return std::nullopt;
+			return layer_gaps.of_layer(layer);
+		}
+
+		/// @brief 指定レイヤーのオブジェクトに挟まれた空き区間のうち，最も長いもの．
+		std::optional<free_interval> largest_gap(State const& s, int layer)
+		{
+			if (!layer_gaps.prepare(s)) return std::nullopt;
+			if (int const k = layer_gaps.idx_largest[layer]; k >= 0) return layer_gaps.of_layer(layer)[k];
+			return free_interval{ 0, 0 };
+		}
+
+		/// @brief 指定レイヤーで，`frame` 以降に始まる長さ `len` 以上の空き区間．
+		std::optional<free_interval> find_gap(State const& s, int layer, int frame, int len)
+		{
+			if (!layer_gaps.prepare(s)) return std::nullopt;
+			auto const gaps = layer_gaps.of_layer(layer);
+
+			// the first gap that ends after `frame`. the last one never ends.
+			int const k = static_cast<int>(std::ranges::upper_bound(gaps.first(gaps.size() - 1), frame, {}, &free_interval::end) - gaps.begin());
+			if (free_interval const gap = { std::max<int32_t>(gaps[k].begin, frame), gaps[k].end };
+				LayerGaps::length(gap) >= len) return gap;
+
+			// the gaps after it begin after `frame`.
+			return gaps[layer_gaps.first_at_least(layer, k + 1, len)];
+		}
+
+		/// @brief オブジェクトのあるレイヤーを上から順に並べたもの．
+		std::optional<std::span<uint8_t const>> nonempty_layers(State const& s)
+		{
+			if (!nonempty_layer_list.prepare(s, current_layer_states(s).nonempty)) return std::nullopt;
+			return nonempty_layer_list.layers;
+		}
+	};
+}
@@ -15,7 +15,6 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 #include <bit>
 #include <memory>
 #include <vector>
-#include <set>
 #include <string>
 
 #define NOMINMAX
@@ -31,6 +30,7 @@ using byte = uint8_t;
 
 #include "../enhanced_tl.hpp"
 #include "../timeline.hpp"
+#include "../timeline_index.hpp"
 #include "../tooltip.hpp"
 #include "tip_contents.hpp"
 #include "draggings.hpp"
@@ -54,7 +54,7 @@ using sigma_lib::string::encode_sys;
 // identifying two objects if they belong to the same chain.
 static size_t count_selected_chains()
 {
-	std::set<int> chains{};
+	enhanced_tl::object_selection chains{};
 
 	// collect leading objects, and return the resulting size.
 	auto const* const objects = *exedit.ObjectArray_ptr;
@@ -265,6 +265,7 @@ protected:
 	{
 		idx_left = (*exedit.ObjectArray_ptr)[idx].index_midpt_leader;
 		if (idx_left < 0) idx_left = idx_right = idx;
+		else if (auto const chain = tl::index::chain_of(idx)) idx_right = chain->tail;
 		else {
 			idx_right = idx;
 			for (int i = idx_right; i >= 0; i = exedit.NextObjectIdxArray[i])
@@ -303,8 +304,11 @@ protected:
 		else {
 			// total length.
 			int idx_right = index_object;
-			for (int i = idx_right; i >= 0; i = exedit.NextObjectIdxArray[i])
-				idx_right = i;
+			if (auto const chain = tl::index::chain_of(index_object)) idx_right = chain->tail;
+			else {
+				for (int i = idx_right; i >= 0; i = exedit.NextObjectIdxArray[i])
+					idx_right = i;
+			}
 			int const
 				len_frame_tot = objects[idx_right].frame_end + 1
 					- objects[obj.index_midpt_leader].frame_begin,
@@ -423,9 +427,12 @@ static update_mode update_tip(int x, int y)
 					int idx_l, idx_r, mid_frame;
 					if (kind == drag_kind::move_object_left) {
 						idx_r = mo::interop::idx_obj_on_mouse;
-						idx_l = obj.index_midpt_leader;
-						for (int i = idx_l; i != idx_r; i = exedit.NextObjectIdxArray[i])
-							idx_l = i;
+						if (auto const chain = tl::index::chain_of(idx_r)) idx_l = chain->prev;
+						else {
+							idx_l = obj.index_midpt_leader;
+							for (int i = idx_l; i != idx_r; i = exedit.NextObjectIdxArray[i])
+								idx_l = i;
+						}
 						mid_frame = mo::interop::former_frame_begin;
 					}
 					else {
@@ -31,6 +31,7 @@ using byte = uint8_t;
 
 #include "../enhanced_tl.hpp"
 #include "../timeline.hpp"
+#include "../timeline_index.hpp"
 #include "../tooltip.hpp"
 #include "tip_contents.hpp"
 #include "objects.hpp"
@@ -209,10 +210,16 @@ inline void Layout::prepare()
 	auto const& obj = target();
 	int pos_chain = 0, num_chain = 0, idx_head = index_object, idx_tail = index_object;
 	if (obj.index_midpt_leader >= 0) {
-		idx_head = obj.index_midpt_leader;
-		for (int j = obj.index_midpt_leader; j >= 0; num_chain++, j = exedit.NextObjectIdxArray[j]) {
-			if (j == index_object) pos_chain = num_chain;
-			idx_tail = j;
+		if (auto const chain = tl::index::chain_of(index_object)) {
+			idx_head = chain->head; idx_tail = chain->tail;
+			pos_chain = chain->pos; num_chain = chain->count;
+		}
+		else {
+			idx_head = obj.index_midpt_leader;
+			for (int j = obj.index_midpt_leader; j >= 0; num_chain++, j = exedit.NextObjectIdxArray[j]) {
+				if (j == index_object) pos_chain = num_chain;
+				idx_tail = j;
+			}
 		}
 	}
 	auto const& head = objects[idx_head]; auto const& tail = objects[idx_tail];
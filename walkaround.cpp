@@ -11,18 +11,33 @@ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR I
 */
 
 #include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <commdlg.h>
 
 using byte = uint8_t;
 #include <exedit.hpp>
 
 #include "inifile_op.hpp"
 #include "key_states.hpp"
+#include "str_encodes.hpp"
 #include "timeline.hpp"
+#include "timeline_index.hpp"
 #include "bpm_grid.hpp"
+#include "audio_analysis.hpp"
+#include "audio_file.hpp"
+#include "audio_peaks.hpp"
+#include "markers.hpp"
+#include "latency_stats.hpp"
 
 #include "enhanced_tl.hpp"
 #include "walkaround.hpp"
@@ -38,6 +53,8 @@ NS_BEGIN()
 namespace timeline = enhanced_tl::timeline;
 namespace tlc = timeline::constants;
 namespace BPM_Grid = enhanced_tl::BPM_Grid;
+namespace audio_peaks = enhanced_tl::audio_peaks;
+namespace markers = enhanced_tl::markers;
 using namespace enhanced_tl::walkaround;
 
 template<HWND*& phwnd, UINT mes_scroll>
@@ -57,6 +74,298 @@ auto& set_v_scroll_pos = set_scroll_pos<exedit.timeline_v_scroll_bar, WM_VSCROLL
 
 static bool scroll_absolute(int dir, AviUtl::EditHandle* editp);
 
+#pragma warning(suppress : 28159) // 32 bit is enough.
+static int get_tick() { return ::GetTickCount(); }
+
+#ifndef NDEBUG
+// キー操作の遅延の集計．`coalesce_repeat` の有無での比較用で，デバッガから読む．
+static constinit latency_stats latency{};
+#endif
+
+// キーリピートで連続する移動・スクロールのコマンドの集約．
+// 前回の適用から画面の更新間隔が経たないうちに届いたコマンドは目標位置だけを更新し，
+// タイマーで正味の移動を一度に適用する．
+static constinit struct Coalescer {
+	std::optional<int32_t> frame{}, h_scroll{}, v_scroll{};
+
+	// 移動先の計算の基準となる位置．保留中の目標があればそれを返す．
+	int32_t curr_frame() const { return frame.value_or(*exedit.curr_edit_frame); }
+	int32_t curr_h_scroll() const { return h_scroll.value_or(*exedit.timeline_h_scroll_pos); }
+	int32_t curr_v_scroll() const { return v_scroll.value_or(*exedit.timeline_v_scroll_pos); }
+
+	// returns `true` to redraw the main window.
+	bool request_frame(int32_t pos, AviUtl::EditHandle* editp)
+	{
+		return request(frame, pos, editp);
+	}
+	void request_h_scroll(int32_t pos, AviUtl::EditHandle* editp)
+	{
+		request(h_scroll, pos, editp);
+	}
+	void request_v_scroll(int32_t pos, AviUtl::EditHandle* editp)
+	{
+		request(v_scroll, pos, editp);
+	}
+
+	// applies the pending targets immediately. returns `true` to redraw the main window.
+	bool flush(AviUtl::EditHandle* editp)
+	{
+		if (!timer_active) return false;
+
+		kill_timer();
+		return apply(editp);
+	}
+	void discard()
+	{
+		kill_timer();
+		frame.reset(); h_scroll.reset(); v_scroll.reset();
+	}
+
+private:
+	bool timer_active = false;
+	int last_apply = 0;
+#ifndef NDEBUG
+	int msg_time = 0;
+#endif
+
+	// the refresh interval of the display in milliseconds.
+	static int interval()
+	{
+		static constinit int ms = 0;
+		if (ms <= 0) {
+			auto const dc = ::GetDC(nullptr);
+			int const hz = ::GetDeviceCaps(dc, VREFRESH);
+			::ReleaseDC(nullptr, dc);
+			ms = 1000 / (hz > 1 ? hz : 60); // 0 or 1 means the default rate.
+		}
+		return ms;
+	}
+
+	bool request(std::optional<int32_t>& target, int32_t pos, AviUtl::EditHandle* editp)
+	{
+#ifndef NDEBUG
+		latency.on_command(get_tick());
+		msg_time = ::GetMessageTime();
+#endif
+		target = pos;
+
+		if (settings.coalesce_repeat &&
+			(timer_active || get_tick() - last_apply < interval())) {
+			// defer until the next refresh.
+			if (!timer_active) {
+				timer_active = true;
+				::SetTimer(enhanced_tl::this_fp->hwnd, timer_id(),
+					std::max<int>(interval() - (get_tick() - last_apply), USER_TIMER_MINIMUM), on_timer);
+			}
+			return false;
+		}
+		return apply(editp);
+	}
+	bool apply(AviUtl::EditHandle* editp)
+	{
+		bool ret = false;
+		if (auto const pos = std::exchange(frame, std::nullopt))
+			ret = move_frame(*pos, editp);
+		if (auto const pos = std::exchange(h_scroll, std::nullopt))
+			set_h_scroll_pos(*pos);
+		if (auto const pos = std::exchange(v_scroll, std::nullopt))
+			set_v_scroll_pos(*pos);
+
+		last_apply = get_tick();
+#ifndef NDEBUG
+		latency.on_applied(msg_time, get_tick());
+#endif
+		return ret;
+	}
+
+	uintptr_t timer_id() const { return reinterpret_cast<uintptr_t>(this); }
+	void kill_timer()
+	{
+		if (!timer_active) return;
+
+		::KillTimer(enhanced_tl::this_fp->hwnd, timer_id());
+		timer_active = false;
+	}
+	static void CALLBACK on_timer(HWND hwnd, UINT, UINT_PTR id, DWORD)
+	{
+		::KillTimer(hwnd, id);
+		if (auto that = reinterpret_cast<Coalescer*>(id);
+			that != nullptr && that->timer_active && hwnd == enhanced_tl::this_fp->hwnd) {
+			that->timer_active = false;
+			if (!::is_editing()) that->discard();
+			else if (that->apply(*exedit.editp))
+				// update the main screen as the return value can't tell it.
+				::update_current_frame();
+		}
+	}
+} coalescer{};
+
+// 移動履歴．訪れた位置を固定長のリングバッファに記録し，「戻る」「進む」で行き来する．
+// プロジェクトファイルと同じ場所に "<プロジェクト名>.nav.bin" として保存する．
+static constinit struct NavHistory {
+	struct place {
+		int32_t frame, scene, h_scroll, v_scroll;
+	};
+	constexpr static int capacity = 64;
+	constexpr static int merge_ms = 500; // これより短い間隔での連続移動は1つにまとめる．
+	constexpr static int near_px = 16; // これより近い位置は同じ位置とみなす．
+
+	static place here()
+	{
+		return { *exedit.curr_edit_frame, *exedit.current_scene,
+			*exedit.timeline_h_scroll_pos, *exedit.timeline_v_scroll_pos };
+	}
+
+	// records a move from `from` to `to`.
+	void record(place const& from, place const& to)
+	{
+		if (navigating) return;
+		sync();
+
+		int const now = get_tick();
+		bool const continuing = size > 0 && cursor == size - 1 &&
+			now - last_record < merge_ms && is_near(top(), from);
+		last_record = now;
+		dirty = true;
+
+		if (continuing) { top() = to; return; } // merge the repeated steps into one.
+		if (size == 0 || !is_near(top(), from)) push(from);
+		if (is_near(top(), to)) {
+			size = cursor + 1; // drop the forward history.
+			top() = to;
+		}
+		else push(to);
+	}
+
+	// returns the place to go back to, or `nullptr` if none.
+	place const* back(place const& curr)
+	{
+		sync();
+		if (size == 0) return nullptr;
+
+		// keep the current place so that "forward" can return here.
+		if (!is_near(top(), curr)) push(curr);
+		if (cursor == 0) return nullptr;
+
+		cursor--; dirty = true;
+		forget_last_record();
+		return &top();
+	}
+	// returns the place to go forward to, or `nullptr` if none.
+	place const* forward(place const& curr)
+	{
+		sync();
+		if (cursor + 1 >= size) return nullptr;
+
+		cursor++; dirty = true;
+		forget_last_record();
+		return &top();
+	}
+
+	// saves the history to the sidecar file and forgets it.
+	void close()
+	{
+		save();
+		path[0] = '\0';
+		size = cursor = 0;
+	}
+
+	// suppresses recording while navigating the history.
+	bool navigating = false;
+
+private:
+	place entries[capacity]{};
+	int begin = 0, size = 0, cursor = 0; // `cursor` is relative to `begin`.
+	int last_record = 0;
+	bool dirty = false;
+	char path[MAX_PATH]{};
+
+	struct file_header {
+		constexpr static uint32_t
+			magic_value = 'E' | ('T' << 8) | ('N' << 16) | ('V' << 24),
+			version_value = 1;
+		uint32_t magic, version;
+		int32_t size, cursor;
+	};
+
+	// makes the next move a new entry rather than merging it into the current one.
+	void forget_last_record() { last_record = get_tick() - merge_ms; }
+
+	place& at(int i) { return entries[(begin + i) % capacity]; }
+	place& top() { return at(cursor); }
+	void push(place const& p)
+	{
+		// drop the forward history.
+		size = cursor + 1;
+		if (size == capacity) {
+			begin = (begin + 1) % capacity;
+			size--;
+		}
+		at(size) = p;
+		cursor = size++;
+	}
+	static bool is_near(place const& a, place const& b)
+	{
+		return a.scene == b.scene && std::abs(timeline::point_from_frame(a.frame) - timeline::point_from_frame(b.frame)) < near_px;
+	}
+
+	// switches the history to that of the current project if necessary.
+	void sync()
+	{
+		char curr[MAX_PATH];
+		project_sidecar_path(curr, ".nav.bin");
+		if (std::strcmp(curr, path) == 0) return;
+
+		// keep the history made before the project was first saved.
+		if (path[0] == '\0' && dirty) {
+			std::strcpy(path, curr);
+			return;
+		}
+
+		close();
+		std::strcpy(path, curr);
+		load();
+	}
+
+	void load()
+	{
+		begin = size = cursor = 0;
+		dirty = false;
+		if (path[0] == '\0') return;
+
+		auto const file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return;
+
+		file_header h{}; DWORD read = 0;
+		if (::ReadFile(file, &h, sizeof(h), &read, nullptr) != FALSE && read == sizeof(h) &&
+			h.magic == file_header::magic_value && h.version == file_header::version_value &&
+			0 < h.size && h.size <= capacity && 0 <= h.cursor && h.cursor < h.size &&
+			::ReadFile(file, entries, h.size * sizeof(place), &read, nullptr) != FALSE &&
+			read == h.size * sizeof(place)) {
+			size = h.size;
+			cursor = h.cursor;
+		}
+		::CloseHandle(file);
+	}
+	void save()
+	{
+		if (!std::exchange(dirty, false) || path[0] == '\0' || size == 0) return;
+
+		auto const file = ::CreateFileA(path, GENERIC_WRITE, 0, nullptr,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return;
+
+		// write the entries in order, oldest first.
+		file_header const h{ file_header::magic_value, file_header::version_value, size, cursor };
+		DWORD written;
+		::WriteFile(file, &h, sizeof(h), &written, nullptr);
+		for (int i = 0; i < size; i++)
+			::WriteFile(file, &at(i), sizeof(place), &written, nullptr);
+		::CloseHandle(file);
+	}
+} history{};
+
 inline static bool step_boundary(bool to_left, bool entire_scene, bool skip_midpt, AviUtl::EditHandle* editp)
 {
 	/* handles:
@@ -72,27 +381,24 @@ inline static bool step_boundary(bool to_left, bool entire_scene, bool skip_midp
 
 	// get the current status.
 	int const
-		pos = *exedit.curr_edit_frame,
+		pos = coalescer.curr_frame(),
 		len = *exedit.curr_scene_len;
 
 	// determine the new position.
 	int new_pos;
 	if (entire_scene || *exedit.SettingDialogObjectIndex < 0) {
 		// search from the entire scene.
-		auto const* const layer_settings = &exedit.LayerSettings[*exedit.current_scene * timeline::constants::num_layers];
-		if (to_left) {
-			new_pos = 0;
-			for (int layer = 0; layer < tlc::num_layers; layer++) {
-				if (!settings.skip_hidden_layers || timeline::is_visible(layer_settings[layer]))
-					new_pos = std::max(new_pos, timeline::find_adjacent_left(pos, layer, skip_midpt, settings.skip_inactive_objects));
-			}
-		}
-		else {
-			new_pos = len - 1;
-			for (int layer = 0; layer < tlc::num_layers; layer++) {
-				if (!settings.skip_hidden_layers || timeline::is_visible(layer_settings[layer]))
-					new_pos = std::min(new_pos, timeline::find_adjacent_right(pos, layer, skip_midpt, settings.skip_inactive_objects, len));
+		new_pos = to_left ?
+			timeline::find_adjacent_left_scene(pos, skip_midpt, settings.skip_inactive_objects, settings.skip_hidden_layers) :
+			timeline::find_adjacent_right_scene(pos, skip_midpt, settings.skip_inactive_objects, settings.skip_hidden_layers, len);
+
+		// markers are also the candidates if specified.
+		if (settings.step_to_markers) {
+			if (to_left) {
+				if (auto const mk = markers::find_left(pos)) new_pos = std::max(new_pos, *mk);
 			}
+			else if (auto const mk = markers::find_right(pos); mk && *mk < len)
+				new_pos = std::min(new_pos, *mk);
 		}
 	}
 	else {
@@ -103,7 +409,7 @@ inline static bool step_boundary(bool to_left, bool entire_scene, bool skip_midp
 			timeline::find_adjacent_right(pos, layer, skip_midpt, settings.skip_inactive_objects, len);
 	}
 	if (pos == new_pos) return false; // no need to move.
-	return move_frame(new_pos, editp);
+	return coalescer.request_frame(new_pos, editp);
 }
 
 inline static bool step_into_obj(bool skip_midpt, AviUtl::EditHandle* editp)
@@ -173,7 +479,7 @@ inline static bool step_length(bool to_left, bool by_page, AviUtl::EditHandle* e
 
 	// get the current status.
 	int const
-		pos = *exedit.curr_edit_frame,
+		pos = coalescer.curr_frame(),
 		len = *exedit.curr_scene_len;
 
 	// determine the distance.
@@ -186,7 +492,7 @@ inline static bool step_length(bool to_left, bool by_page, AviUtl::EditHandle* e
 	int new_pos = std::clamp(pos + dist, 0, len - 1);
 
 	if (pos == new_pos) return false; // no need to move.
-	return move_frame(new_pos, editp);
+	return coalescer.request_frame(new_pos, editp);
 }
 
 inline static bool step_bpm_grid(bool to_left, int beats_numer, int beats_denom, AviUtl::EditHandle* editp)
@@ -204,11 +510,11 @@ inline static bool step_bpm_grid(bool to_left, int beats_numer, int beats_denom,
 
 	// get the current status.
 	int const
-		pos = *exedit.curr_edit_frame,
+		pos = coalescer.curr_frame(),
 		len = *exedit.curr_scene_len;
 
 	// determine the new position.
-	BPM_Grid::BPM_Grid const grid{ beats_numer, beats_denom };
+	auto const& grid = BPM_Grid::current_grid(beats_numer, beats_denom);
 	int new_pos = to_left ?
 		grid.pos_from_beat(grid.beat_from_pos(pos - 1)) :
 		grid.pos_from_beat(grid.beat_from_pos(pos) + 1);
@@ -216,7 +522,7 @@ inline static bool step_bpm_grid(bool to_left, int beats_numer, int beats_denom,
 	new_pos = std::clamp(new_pos, 0, len - 1);
 
 	if (pos == new_pos) return false; // no need to move.
-	return move_frame(new_pos, editp);
+	return coalescer.request_frame(new_pos, editp);
 }
 
 inline static bool move_bpm_grid(int dir, AviUtl::EditHandle* editp)
@@ -233,6 +539,9 @@ inline static bool move_bpm_grid(int dir, AviUtl::EditHandle* editp)
 	{ menu::bpm_fit_bar_to_current,		"最寄りの小節線を現在位置に(BPM)" },
 	*/
 
+	// the tempo map ignores the origin, so moving it would change nothing the commands follow.
+	if (BPM_Grid::has_tempo_map()) return false;
+
 	// get the current status.
 	int const origin = *exedit.timeline_BPM_frame_origin;
 
@@ -278,7 +587,7 @@ inline static bool scroll_length(bool to_left, bool by_page, AviUtl::EditHandle*
 	*/
 
 	// get the current status.
-	int const pos = *exedit.timeline_h_scroll_pos;
+	int const pos = coalescer.curr_h_scroll();
 
 	// determine the distance.
 	int dist = by_page ?
@@ -290,7 +599,7 @@ inline static bool scroll_length(bool to_left, bool by_page, AviUtl::EditHandle*
 	int const new_pos = pos + dist;
 
 	if (pos == new_pos) return false; // no need to move.
-	set_h_scroll_pos(new_pos);
+	coalescer.request_h_scroll(new_pos, editp);
 	return false;
 }
 
@@ -339,7 +648,7 @@ inline static bool scroll_layer(bool to_up, AviUtl::EditHandle* editp)
 	*/
 
 	// get the current status.
-	int const pos = *exedit.timeline_v_scroll_pos;
+	int const pos = coalescer.curr_v_scroll();
 
 	// determine the new position.
 	int const new_pos = std::clamp(
@@ -347,71 +656,428 @@ inline static bool scroll_layer(bool to_up, AviUtl::EditHandle* editp)
 		0, tlc::num_layers - 1);
 
 	if (pos == new_pos) return false; // no need to move.
-	set_v_scroll_pos(new_pos);
+	coalescer.request_v_scroll(new_pos, editp);
 	return false;
 }
 
-// 拡張編集の「現在のオブジェクトを選択」コマンドの ID.
-constexpr static int exedit_command_select_obj = 1050;
 inline static bool select_object(bool to_up, AviUtl::EditHandle* editp)
 {
 	/* handles:
 	{ menu::select_upper_obj,		    "現在フレームのオブジェクトへ移動(上)" },
 	{ menu::select_lower_obj,		    "現在フレームのオブジェクトへ移動(下)" },
 	*/
+	// 拡張編集の「現在のオブジェクトを選択」コマンド (ID: 1050) と同等の処理．
 
-	// fake shift key state.
-	sigma_lib::W32::UI::ForceKeyState k{ VK_SHIFT, to_up };
+	// get the current status.
+	int const
+		pos = *exedit.curr_edit_frame,
+		idx_curr = *exedit.SettingDialogObjectIndex,
+		layer_curr = idx_curr >= 0 ? (*exedit.ObjectArray_ptr)[idx_curr].layer_set :
+			to_up ? tlc::num_layers : -1;
+
+	// find the nearest object at the current frame in the direction.
+	int idx_new = -1, layer_new = -1;
+	timeline::objects_at_frame(pos, to_up, [&](int idx, int layer) {
+		if (to_up ? layer >= layer_curr : layer <= layer_curr) return true;
+		idx_new = idx; layer_new = layer;
+		return false;
+	});
+	if (idx_new < 0) return false; // no object found.
+
+	// select the object, deselecting others as the command does.
+	*exedit.SettingDialogObjectIndex = idx_new;
+	{
+		sigma_lib::W32::UI::ForceKeyState k{ VK_CONTROL, false }; // otherwise the selection is kept.
+		update_setting_dialog(idx_new);
+	}
+	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
 
-	// 拡張編集にコマンドメッセージ送信．
-	return exedit.fp->func_WndProc(exedit.fp->hwnd, AviUtl::FilterPlugin::WindowMessage::Command,
-		exedit_command_select_obj, 0, editp, exedit.fp) != FALSE;
+	// scroll so the layer of the object is visible.
+	if (int const top = *exedit.timeline_v_scroll_pos, height = *exedit.timeline_height_in_layers;
+		layer_new < top) set_v_scroll_pos(layer_new);
+	else if (layer_new >= top + height) set_v_scroll_pos(layer_new - height + 1);
+	return true;
 }
 
-inline static bool set_scene_rel(int32_t delta, AviUtl::EditHandle* editp)
+// 各位置を最も近い BPM グリッド線に置き換える．距離が等しい場合は左の線を選ぶ．
+// 位置は昇順に並べ替えてから，拍数線の列挙と突き合わせてまとめて求める．
+static void snap_to_grid_lines(BPM_Grid::TempoGrid const& grid, std::vector<std::pair<int32_t, int32_t*>>& targets)
+{
+	auto const nearest = [](int32_t pos, int32_t l, int32_t r) {
+		return pos - l <= r - pos ? l : r;
+	};
+
+	std::ranges::sort(targets);
+	int32_t const
+		pos_L = targets.front().first, pos_R = targets.back().first;
+	auto const
+		beat_L = grid.beat_from_pos(pos_L), beat_R = grid.beat_from_pos(pos_R);
+
+	// too many lines lie between the positions; convert each position separately.
+	if (beat_R - beat_L > static_cast<int64_t>(4 * targets.size())) {
+		for (auto& [pos, dest] : targets) {
+			auto const beat = grid.beat_from_pos(pos);
+			*dest = nearest(pos, grid.pos_from_beat(beat), grid.pos_from_beat(beat + 1));
+		}
+		return;
+	}
+
+	// sweep the lines from the one at or left of the leftmost position.
+	auto line = grid.lines_in(grid.pos_from_beat(beat_L), grid.pos_from_beat(beat_R + 1)).begin();
+	int32_t l = (*line).pos; ++line;
+	for (auto& [pos, dest] : targets) {
+		while ((*line).pos <= pos) { l = (*line).pos; ++line; }
+		*dest = nearest(pos, l, (*line).pos);
+	}
+}
+
+inline static bool quantize_to_bpm_grid(bool both_ends, AviUtl::EditHandle* editp)
 {
 	/* handles:
-	{ menu::change_scene_prev,			"前のシーンに切り替え" },
-	{ menu::change_scene_next,			"次のシーンに切り替え" },
+	{ menu::quantize_bpm_begin,			"選択オブジェクトをグリッドに揃える(BPM)" },
+	{ menu::quantize_bpm_both,			"選択オブジェクトの両端をグリッドに揃える(BPM)" },
 	*/
 
-	return set_scene_index(*exedit.current_scene + delta, editp);
+	// collect the selected objects, or the one in the setting dialog.
+	auto sel = get_multi_selected_objects();
+	if (sel.empty() && *exedit.SettingDialogObjectIndex >= 0)
+		sel.insert(*exedit.SettingDialogObjectIndex);
+	if (sel.empty()) return false;
+
+	int const N = settings.BPM_quantize;
+	auto const& grid = N >= 0 ?
+		BPM_Grid::current_grid(1, std::max(N, 1)) : // 1 / N beats.
+		BPM_Grid::current_grid(N, 1); // (-N) measure lines.
+	if (!grid) return false;
+
+	// split each layer into runs of objects connected by midpoints.
+	struct chain {
+		int layer, first, last; // the range in `exedit.SortedObject`.
+		int32_t begin, end, new_begin, new_end;
+		bool selected;
+	};
+	std::vector<chain> chains{};
+	auto const* const head_ptr = *exedit.ObjectArray_ptr;
+	auto const& layer_states = timeline::index::current_layer_states();
+	for (int layer : layer_states.nonempty & ~layer_states.locked) {
+		// objects on locked layers stay where they are.
+		int const
+			L = exedit.SortedObjectLayerBeginIndex[layer],
+			R = exedit.SortedObjectLayerEndIndex[layer];
+		for (int j = L; j <= R; j++) {
+			auto const* const obj = exedit.SortedObject[j];
+			bool const selected = sel.contains(obj - head_ptr);
+			if (j > L && obj->index_midpt_leader >= 0 &&
+				obj->index_midpt_leader == exedit.SortedObject[j - 1]->index_midpt_leader) {
+				auto& c = chains.back();
+				c.last = j; c.end = c.new_end = obj->frame_end;
+				c.selected |= selected;
+			}
+			else chains.push_back({ layer, j, j,
+				obj->frame_begin, obj->frame_end, obj->frame_begin, obj->frame_end, selected });
+		}
+	}
+
+	// find the grid lines for all the boundaries at once.
+	std::vector<std::pair<int32_t, int32_t*>> targets{};
+	for (auto& c : chains) {
+		if (!c.selected) continue;
+		targets.emplace_back(c.begin, &c.new_begin);
+		if (both_ends) targets.emplace_back(c.end + 1, &c.new_end);
+	}
+	if (targets.empty()) return false;
+	snap_to_grid_lines(grid, targets);
+
+	// settle the new positions from left to right on each layer.
+	// a chain moves only if it fits between the settled chain on the left
+	// and the not-yet-moved chain on the right, so the result doesn't depend on the order of selection.
+	for (size_t k = 0; k < chains.size(); k++) {
+		auto& c = chains[k];
+		if (!c.selected) continue;
+
+		int32_t const shift = c.new_begin - c.begin;
+		c.new_end = both_ends ? c.new_end - 1 : c.end + shift;
+		// keep the last piece at least one frame long.
+		c.new_end = std::max(c.new_end, exedit.SortedObject[c.last]->frame_begin + shift);
+
+		if (c.new_begin < 0 ||
+			(k > 0 && chains[k - 1].layer == c.layer && chains[k - 1].new_end >= c.new_begin) ||
+			(k + 1 < chains.size() && chains[k + 1].layer == c.layer && c.new_end >= chains[k + 1].begin))
+			c.new_begin = c.begin, c.new_end = c.end;
+	}
+
+	// apply the changes as a single undo step.
+	int const dlg_obj_idx = *exedit.SettingDialogObjectIndex;
+	bool modified = false, should_update_dialog = false;
+	for (auto const& c : chains) {
+		if (c.new_begin == c.begin && c.new_end == c.end) continue;
+		if (!modified) {
+			exedit.nextundo();
+			modified = true;
+		}
+
+		int32_t const shift = c.new_begin - c.begin;
+		for (int j = c.first; j <= c.last; j++) {
+			auto* const obj = exedit.SortedObject[j];
+			int const index = obj - head_ptr;
+
+			exedit.setundo(index, 0x08);
+			obj->frame_begin += shift;
+			obj->frame_end = j < c.last ? obj->frame_end + shift : c.new_end;
+
+			if (index == dlg_obj_idx) should_update_dialog = true;
+		}
+	}
+	if (!modified) return false;
+
+	// re-construct internal object tables.
+	exedit.update_object_tables();
+	timeline::index::invalidate();
+
+	// redraw the timeline.
+	::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
+
+	// update the dialog if the moved object is selected.
+	if (should_update_dialog) {
+		sigma_lib::W32::UI::ForceKeyState k{ VK_CONTROL, true }; // otherwise objects are deselected.
+		update_setting_dialog(dlg_obj_idx);
+	}
+	return true;
 }
-NS_END
 
+// WAV ファイルを選択するダイアログを表示する．
+static bool choose_wav_file(wchar_t(&path)[MAX_PATH])
+{
+	OPENFILENAMEW ofn{
+		.lStructSize = sizeof(ofn),
+		.hwndOwner = exedit.fp->hwnd,
+		.lpstrFilter = L"WAV ファイル (*.wav)\0*.wav\0すべてのファイル (*.*)\0*.*\0",
+		.lpstrFile = path,
+		.nMaxFile = static_cast<DWORD>(std::size(path)),
+		.Flags = OFN_FILEMUSTEXIST | OFN_HIDEREADONLY,
+	};
+	return ::GetOpenFileNameW(&ofn) != FALSE;
+}
 
-////////////////////////////////
-// exported functions.
-////////////////////////////////
-namespace expt = enhanced_tl::walkaround;
+// 音声の先頭に対応するフレーム位置．設定ダイアログのオブジェクトの開始位置で，なければ 0.
+static int32_t audio_start_frame()
+{
+	int const idx = *exedit.SettingDialogObjectIndex;
+	return idx >= 0 ? (*exedit.ObjectArray_ptr)[idx].frame_begin : 0;
+}
 
-void expt::Settings::load(char const* ini_file)
+static bool show_error(wchar_t const* mes)
 {
-	using namespace sigma_lib::inifile;
-	constexpr auto section = "walkaround";
-	constexpr static int
-		BPM_nth_min = 2, BPM_nth_max = 128,
-		rate_min = 1, rate_max = 16'000;
+	::MessageBoxW(exedit.fp->hwnd, mes,
+		sigma_lib::string::encode_sys::to_wide_str(enhanced_tl::this_fp->name).c_str(),
+		MB_OK | MB_ICONEXCLAMATION);
+	return false;
+}
 
-#define read(func, fld, ...)	fld = read_##func(fld, ini_file, section, #fld __VA_OPT__(,) __VA_ARGS__)
+constexpr wchar_t const* unsupported_wav_message =
+	L"対応していない形式のファイルです．\n(PCM または浮動小数点形式の WAV ファイルに対応しています．)";
 
-	read(bool,	skip_inactive_objects);
-	read(bool,	skip_hidden_layers);
-	read(bool,	suppress_shift);
-	read(int,	BPM_nth, BPM_nth_min, BPM_nth_max);
-	read(int,	scroll_amount_layer, 1, tlc::num_layers - 1);
-	read(int,	scroll_amount_time, rate_min, rate_max);
-	read(int,	step_amount_time, rate_min, rate_max);
+inline static bool detect_bpm_from_wav(AviUtl::EditHandle* editp)
+{
+	/* handles:
+	{ menu::bpm_detect_from_wav,		"WAVファイルからテンポを推定(BPM)" },
+	*/
 
-#undef read
+	// the frame rate is needed to place the origin.
+	AviUtl::FileInfo fi{};
+	enhanced_tl::this_fp->exfunc->get_file_info(editp, &fi);
+	if (fi.video_rate <= 0 || fi.video_scale <= 0) return false;
+
+	// choose the file.
+	wchar_t path[MAX_PATH]{};
+	if (!choose_wav_file(path)) return false;
+
+	// analyze the audio while streaming the file.
+	namespace aa = enhanced_tl::audio_analysis;
+	std::optional<aa::tempo_estimate> est{};
+	{
+		auto const prev_cursor = ::SetCursor(::LoadCursorW(nullptr, reinterpret_cast<wchar_t const*>(IDC_WAIT)));
+		enhanced_tl::audio_file::mapped_wav wav{ path };
+		if (wav) {
+			aa::onset_envelope env{ wav.format().sample_rate };
+			if (wav.stream_mono([&](std::span<float const> samples) { env.feed(samples); }))
+				est = aa::estimate_tempo(env.finish(), env.hop_seconds(), env.time_offset());
+		}
+		::SetCursor(prev_cursor);
+		if (!wav) return show_error(unsupported_wav_message);
+	}
+	if (!est) return show_error(L"テンポを推定できませんでした．");
+
+	// convert to the BPM settings of exedit.
+	int32_t const
+		tempo = static_cast<int32_t>(std::lround(est->bpm * 10'000)),
+		start = audio_start_frame(),
+		origin = start + static_cast<int32_t>(std::lround(est->first_beat * fi.video_rate / fi.video_scale));
+	if (tempo == *exedit.timeline_BPM_tempo &&
+		origin + 1 == *exedit.timeline_BPM_frame_origin) return false; // no need to change.
+
+	// apply the new values.
+	*exedit.timeline_BPM_tempo = tempo;
+	*exedit.timeline_BPM_frame_origin = origin + 1;
+
+	// redraw the grid if it's visible.
+	if (*exedit.timeline_BPM_show_grid != 0)
+		::InvalidateRect(exedit.fp->hwnd, nullptr, FALSE);
+
+	return false;
 }
 
-bool expt::on_menu_command(HWND hwnd, int32_t menu_id, AviUtl::EditHandle* editp)
+inline static bool load_wave(AviUtl::EditHandle* editp)
 {
-	if (editp == nullptr ||
-		!enhanced_tl::this_fp->exfunc->is_editing(editp) ||
-		enhanced_tl::this_fp->exfunc->is_saving(editp)) return false;
+	/* handles:
+	{ menu::wave_load,					"波形移動用のWAVファイルを開く" },
+	*/
+
+	AviUtl::FileInfo fi{};
+	enhanced_tl::this_fp->exfunc->get_file_info(editp, &fi);
+	if (fi.video_rate <= 0 || fi.video_scale <= 0) return false;
+
+	wchar_t path[MAX_PATH]{};
+	if (!choose_wav_file(path)) return false;
+
+	// builds the peaks unless cached, which streams the entire file.
+	auto const prev_cursor = ::SetCursor(::LoadCursorW(nullptr, reinterpret_cast<wchar_t const*>(IDC_WAIT)));
+	bool const loaded = audio_peaks::load(path, audio_start_frame(), fi.video_rate, fi.video_scale);
+	::SetCursor(prev_cursor);
+
+	if (!loaded) return show_error(unsupported_wav_message);
+	return false;
+}
+
+inline static bool step_transient(bool to_left, AviUtl::EditHandle* editp)
+{
+	/* handles:
+	{ menu::step_transient_left,		"左の音の立ち上がりに移動(波形)" },
+	{ menu::step_transient_right,		"右の音の立ち上がりに移動(波形)" },
+	*/
+
+	// get the current status.
+	int const
+		pos = coalescer.curr_frame(),
+		len = *exedit.curr_scene_len;
+
+	// determine the new position.
+	auto const found = audio_peaks::find_transient(pos, to_left, settings.transient_threshold);
+	if (!found) return false;
+	int const new_pos = std::clamp(*found, 0, len - 1);
+
+	if (pos == new_pos) return false; // no need to move.
+	return coalescer.request_frame(new_pos, editp);
+}
+
+inline static bool step_history(bool to_back, AviUtl::EditHandle* editp)
+{
+	/* handles:
+	{ menu::history_back,				"移動履歴を戻る" },
+	{ menu::history_forward,			"移動履歴を進む" },
+	*/
+
+	auto const* const dest = to_back ?
+		history.back(NavHistory::here()) : history.forward(NavHistory::here());
+	if (dest == nullptr) return false;
+	auto const place = *dest;
+
+	// restore the scene, the frame and the scroll positions, without recording them.
+	history.navigating = true;
+	bool ret = set_scene_index(place.scene, editp);
+	ret |= move_frame(std::clamp(place.frame, 0, *exedit.curr_scene_len - 1), editp);
+	set_h_scroll_pos(place.h_scroll);
+	set_v_scroll_pos(place.v_scroll);
+	history.navigating = false;
+
+	return ret;
+}
+
+inline static bool step_marker(bool to_left, AviUtl::EditHandle* editp)
+{
+	/* handles:
+	{ menu::step_marker_left,			"左のマーカーに移動" },
+	{ menu::step_marker_right,			"右のマーカーに移動" },
+	*/
+
+	// get the current status.
+	int const
+		pos = coalescer.curr_frame(),
+		len = *exedit.curr_scene_len;
+
+	// determine the new position.
+	auto const found = to_left ? markers::find_left(pos) : markers::find_right(pos);
+	if (!found) return false;
+	int const new_pos = std::clamp(*found, 0, len - 1);
+
+	if (pos == new_pos) return false; // no need to move.
+	return coalescer.request_frame(new_pos, editp);
+}
+
+inline static bool edit_marker(bool clear, AviUtl::EditHandle* editp)
+{
+	/* handles:
+	{ menu::marker_toggle,				"現在位置のマーカーを追加/削除" },
+	{ menu::marker_clear_scene,			"現在シーンのマーカーをすべて削除" },
+	*/
+
+	if (clear) markers::clear_scene();
+	else markers::toggle(*exedit.curr_edit_frame);
+	return false;
+}
+
+inline static bool set_scene_rel(int32_t delta, AviUtl::EditHandle* editp)
+{
+	/* handles:
+	{ menu::change_scene_prev,			"前のシーンに切り替え" },
+	{ menu::change_scene_next,			"次のシーンに切り替え" },
+	*/
+
+	return set_scene_index(*exedit.current_scene + delta, editp);
+}
 
+// 集約の対象となる相対移動のコマンドか．
+static bool is_coalescable(int32_t menu_id)
+{
+	switch (menu_id) {
+	case menu::step_obj_left:
+	case menu::step_obj_left_all:
+	case menu::step_obj_right:
+	case menu::step_obj_right_all:
+	case menu::step_midpt_left:
+	case menu::step_midpt_left_all:
+	case menu::step_midpt_right:
+	case menu::step_midpt_right_all:
+	case menu::step_len_left:
+	case menu::step_len_right:
+	case menu::step_page_left:
+	case menu::step_page_right:
+	case menu::step_bpm_measure_left:
+	case menu::step_bpm_measure_right:
+	case menu::step_bpm_beat_left:
+	case menu::step_bpm_beat_right:
+	case menu::step_bpm_quarter_left:
+	case menu::step_bpm_quarter_right:
+	case menu::step_bpm_nth_left:
+	case menu::step_bpm_nth_right:
+	case menu::scroll_left:
+	case menu::scroll_right:
+	case menu::scroll_page_left:
+	case menu::scroll_page_right:
+	case menu::scroll_up:
+	case menu::scroll_down:
+	case menu::step_transient_left:
+	case menu::step_transient_right:
+	case menu::step_marker_left:
+	case menu::step_marker_right:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool handle_command(int32_t menu_id, AviUtl::EditHandle* editp)
+{
 	// switch by menu_id.
 	switch (menu_id) {
 	case menu::step_obj_left:			return step_boundary(true, false, true, editp);
@@ -429,8 +1095,8 @@ bool expt::on_menu_command(HWND hwnd, int32_t menu_id, AviUtl::EditHandle* editp
 	case menu::step_page_left:			return step_length(true, true, editp);
 	case menu::step_page_right:			return step_length(false, true, editp);
 
-	case menu::step_bpm_measure_left:	return step_bpm_grid(true, *exedit.timeline_BPM_num_beats, 1, editp);
-	case menu::step_bpm_measure_right:	return step_bpm_grid(false, *exedit.timeline_BPM_num_beats, 1, editp);
+	case menu::step_bpm_measure_left:	return step_bpm_grid(true, -1, 1, editp);
+	case menu::step_bpm_measure_right:	return step_bpm_grid(false, -1, 1, editp);
 	case menu::step_bpm_beat_left:		return step_bpm_grid(true, 1, 1, editp);
 	case menu::step_bpm_beat_right:		return step_bpm_grid(false, 1, 1, editp);
 	case menu::step_bpm_quarter_left:	return step_bpm_grid(true, 1, 4, editp);
@@ -465,20 +1131,92 @@ bool expt::on_menu_command(HWND hwnd, int32_t menu_id, AviUtl::EditHandle* editp
 	case menu::change_scene_prev:		return set_scene_rel(-1, editp);
 	case menu::change_scene_next:		return set_scene_rel(+1, editp);
 
+	case menu::quantize_bpm_begin:		return quantize_to_bpm_grid(false, editp);
+	case menu::quantize_bpm_both:		return quantize_to_bpm_grid(true, editp);
+	case menu::bpm_detect_from_wav:		return detect_bpm_from_wav(editp);
+
+	case menu::wave_load:				return load_wave(editp);
+	case menu::step_transient_left:		return step_transient(true, editp);
+	case menu::step_transient_right:	return step_transient(false, editp);
+
+	case menu::history_back:			return step_history(true, editp);
+	case menu::history_forward:			return step_history(false, editp);
+
+	case menu::step_marker_left:		return step_marker(true, editp);
+	case menu::step_marker_right:		return step_marker(false, editp);
+	case menu::marker_toggle:			return edit_marker(false, editp);
+	case menu::marker_clear_scene:		return edit_marker(true, editp);
 
 	[[unlikely]] default: return false;
 	}
 }
 
+NS_END
+
+
+////////////////////////////////
+// exported functions.
+////////////////////////////////
+namespace expt = enhanced_tl::walkaround;
+
+void expt::Settings::load(char const* ini_file)
+{
+	using namespace sigma_lib::inifile;
+	constexpr auto section = "walkaround";
+	constexpr static int
+		BPM_nth_min = 2, BPM_nth_max = 128,
+		rate_min = 1, rate_max = 16'000;
+
+#define read(func, fld, ...)	fld = read_##func(fld, ini_file, section, #fld __VA_OPT__(,) __VA_ARGS__)
+
+	read(bool,	skip_inactive_objects);
+	read(bool,	skip_hidden_layers);
+	read(bool,	step_to_markers);
+	read(bool,	suppress_shift);
+	read(bool,	coalesce_repeat);
+	read(int,	BPM_nth, BPM_nth_min, BPM_nth_max);
+	read(int,	BPM_quantize, -16, BPM_nth_max);
+	read(int,	transient_threshold, 1, 1000);
+	read(int,	scroll_amount_layer, 1, tlc::num_layers - 1);
+	read(int,	scroll_amount_time, rate_min, rate_max);
+	read(int,	step_amount_time, rate_min, rate_max);
+
+#undef read
+}
+
+bool expt::on_menu_command(HWND hwnd, int32_t menu_id, AviUtl::EditHandle* editp)
+{
+	if (editp == nullptr ||
+		!enhanced_tl::this_fp->exfunc->is_editing(editp) ||
+		enhanced_tl::this_fp->exfunc->is_saving(editp)) return false;
+
+	// commands other than relative moves should see the pending moves applied.
+	bool const flushed = !is_coalescable(menu_id) && coalescer.flush(editp);
+	return handle_command(menu_id, editp) || flushed;
+}
+
+void expt::discard_pending_moves()
+{
+	coalescer.discard();
+}
+
+void expt::close_history()
+{
+	history.close();
+}
+
 bool expt::move_frame(int pos, AviUtl::EditHandle* editp)
 {
+	// an explicit move supersedes the pending one.
+	coalescer.frame.reset();
+
 	// disable shift key to suppress unintended selection.
 	namespace ui = sigma_lib::W32::UI;
 	ui::ForceKeyState shift{ VK_SHIFT, settings.suppress_shift ? ui::key_map::off : ui::key_map::id };
 
 	// move the frame position.
-	if (int const old_pos = *exedit.curr_edit_frame;
-		old_pos == enhanced_tl::this_fp->exfunc->set_frame(editp, pos)) return false; // no move happend.
+	auto const from = NavHistory::here();
+	if (from.frame == enhanced_tl::this_fp->exfunc->set_frame(editp, pos)) return false; // no move happend.
 
 	// 拡張編集のバグで，「カーソル移動時に自動でスクロール」を設定していても，
 	// 「選択オブジェクトの追従」が有効でかつ移動先で新たなオブジェクトが選択された場合，
@@ -486,6 +1224,8 @@ bool expt::move_frame(int pos, AviUtl::EditHandle* editp)
 	if (*exedit.scroll_follows_cursor != 0)
 		scroll_absolute(0, editp);
 
+	history.record(from, NavHistory::here());
+
 	// true を返して出力画面を更新させる．
 	return true;
 }
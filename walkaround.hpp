@@ -30,8 +30,12 @@ namespace enhanced_tl::walkaround
 
 		bool skip_inactive_objects = false;
 		bool skip_hidden_layers = false;
+		bool step_to_markers = false; // シーン全体の境界移動でマーカーも移動先の候補にする．
 		bool suppress_shift = true;
+		bool coalesce_repeat = true; // キーリピートによる移動を画面の更新間隔ごとにまとめる．
 		uint8_t BPM_nth = 3;
+		int8_t BPM_quantize = 1; // 正の値 N で 1/N 拍，負の値 -N で N 小節．
+		int16_t transient_threshold = 250; // 音の立ち上がりとみなす振幅，フルスケールに対する千分率．
 		int32_t scroll_amount_layer = 1;
 		int32_t scroll_amount_time = config_rate_denom;
 		int32_t step_amount_time = config_rate_denom;
@@ -91,6 +95,23 @@ namespace enhanced_tl::walkaround
 
 			change_scene_prev,
 			change_scene_next,
+
+			quantize_bpm_begin,
+			quantize_bpm_both,
+
+			bpm_detect_from_wav,
+
+			wave_load,
+			step_transient_left,
+			step_transient_right,
+
+			history_back,
+			history_forward,
+
+			marker_toggle,
+			marker_clear_scene,
+			step_marker_left,
+			step_marker_right,
 		};
 		struct item {
 			int32_t id; char const* title;
@@ -108,6 +129,12 @@ namespace enhanced_tl::walkaround
 		{ menu::step_into_sel_midpt,	    "現在位置を選択中間点区間に移動" },
 		{ menu::step_into_sel_obj,		    "現在位置を選択オブジェクトに移動" },
 		{ menu::step_into_view,			    "現在位置をTL表示範囲内に移動" },
+		{ menu::history_back,				"移動履歴を戻る" },
+		{ menu::history_forward,			"移動履歴を進む" },
+		{ menu::step_marker_left,			"左のマーカーに移動" },
+		{ menu::step_marker_right,			"右のマーカーに移動" },
+		{ menu::marker_toggle,				"現在位置のマーカーを追加/削除" },
+		{ menu::marker_clear_scene,			"現在シーンのマーカーをすべて削除" },
 		{ menu::step_len_left,			    "左へ一定量移動" },
 		{ menu::step_len_right,			    "右へ一定量移動" },
 		{ menu::step_page_left,			    "左へ1ページ分移動" },
@@ -124,6 +151,12 @@ namespace enhanced_tl::walkaround
 		{ menu::bpm_move_origin_right,	    "グリッドを右に移動(BPM)" },
 		{ menu::bpm_move_origin_current,    "基準フレームを現在位置に(BPM)" },
 		{ menu::bpm_fit_bar_to_current,		"最寄りの小節線を現在位置に(BPM)" },
+		{ menu::quantize_bpm_begin,			"選択オブジェクトをグリッドに揃える(BPM)" },
+		{ menu::quantize_bpm_both,			"選択オブジェクトの両端をグリッドに揃える(BPM)" },
+		{ menu::bpm_detect_from_wav,		"WAVファイルからテンポを推定(BPM)" },
+		{ menu::wave_load,					"波形移動用のWAVファイルを開く" },
+		{ menu::step_transient_left,		"左の音の立ち上がりに移動(波形)" },
+		{ menu::step_transient_right,		"右の音の立ち上がりに移動(波形)" },
 		{ menu::scroll_left,			    "TLスクロール(左)" },
 		{ menu::scroll_right,			    "TLスクロール(右)" },
 		{ menu::scroll_page_left,		    "TLスクロール(左ページ)" },
@@ -152,6 +185,12 @@ namespace enhanced_tl::walkaround
 	/// @return `true` to redraw the window, `false` otherwise.
 	bool move_frame(int pos, AviUtl::EditHandle* editp);
 
+	/// @brief discards the moves and scrolls deferred by key-repeat coalescing.
+	void discard_pending_moves();
+
+	/// @brief saves the navigation history of the current project to its sidecar file and forgets it.
+	void close_history();
+
 	/// @brief sets the scroll position of the timeline.
 	/// @param pos the position to set the scroll to.
 	/// @param editp not used.